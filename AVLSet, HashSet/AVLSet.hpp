@@ -5,40 +5,81 @@
 //
 // An AVLSet is an implementation of a Set that is an AVL tree, which uses
 // the algorithms we discussed in lecture to maintain balance every time a
-// new element is added to the set.  The balancing is actually optional,
-// with a bool parameter able to be passed to the constructor to explicitly
-// turn the balancing on or off (on is default).  If the balancing is off,
-// the AVL tree acts like a binary search tree (e.g., it will become
-// degenerate if elements are added in ascending order).
+// new element is added to (or removed from) the set.  The balancing is
+// actually optional, with a bool parameter able to be passed to the
+// constructor to explicitly turn the balancing on or off (on is default).
+// If the balancing is off, the AVL tree acts like a binary search tree
+// (e.g., it will become degenerate if elements are added in ascending
+// order).
 //
 // You are not permitted to use the containers in the C++ Standard Library
 // (such as std::set, std::map, or std::vector) to store the information
 // in your data structure.  Instead, you'll need to implement your AVL tree
 // using your own dynamically-allocated nodes, with pointers connecting them,
 // and with your own balancing algorithms used.
+//
+// The nodes are allocated from a NodePool (see NodePool.hpp), so they're
+// packed together in large slabs rather than allocated one at a time.
+//
+// The elements can be visited in order with iterators (including with a
+// range-based for loop), or in any of the three depth-first orders with
+// the traversal functions.  None of these recurse: every node knows its
+// parent, so the next node in any of the orders can be found by walking
+// the tree directly, and a degenerate tree can't overflow the stack.
+//
+// The elements are ordered by a Compare object, which is std::less<>
+// (and so the < operator) unless another is given.  As with the std::set
+// of the C++ Standard Library, it can be a stateful object, and it may
+// also be able to compare the elements with other types of keys, which
+// can then be looked up with containsKey() without making them into
+// elements; std::less<> can, so an AVLSet<std::string> can look up a
+// std::string_view without copying it.
 
 #ifndef AVLSET_HPP
 #define AVLSET_HPP
 
+#include <cstddef>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ModificationCounted.hpp"
+#include "NodePool.hpp"
+#include "PrefixScanner.hpp"
 #include "Set.hpp"
 
 
 
-template <typename ElementType>
-class AVLSet : public Set<ElementType>
+template <typename ElementType, typename Compare = std::less<>>
+class AVLSet
+    : public Set<ElementType>, public ModificationCounted,
+      public PrefixScannerBase<ElementType, Compare>
 {
 public:
     // A VisitFunction is a function that takes a reference to a const
     // ElementType and returns no value.
     using VisitFunction = std::function<void(const ElementType&)>;
 
+    class const_iterator;
+    using iterator = const_iterator;
+
 public:
     // Initializes an AVLSet to be empty, with or without balancing.
     explicit AVLSet(bool shouldBalance = true);
 
+    // Initializes an AVLSet to be empty, ordering its elements with the
+    // given Compare object.
+    explicit AVLSet(const Compare& compare, bool shouldBalance = true);
+
+    // Initializes an AVLSet containing the elements in the range
+    // [first, last), with or without balancing.  See assign().
+    template <typename ForwardIterator>
+    AVLSet(ForwardIterator first, ForwardIterator last, bool shouldBalance = true);
+
     // Cleans up the AVLSet so that it leaks no memory.
     ~AVLSet() noexcept override;
 
@@ -61,10 +102,41 @@ public:
     bool isImplemented() const noexcept override;
 
 
+    // assign() replaces the contents of the set with the elements in the
+    // range [first, last), building a perfectly balanced tree directly
+    // rather than adding the elements one at a time.  If the range is
+    // already sorted in ascending order with no duplicates, this runs in
+    // O(n) time; otherwise, the elements are also sorted and deduplicated,
+    // which takes O(n log n) time.  Either way, the range is copied before
+    // the set is emptied, so it may refer to the set's own elements, and
+    // an exception thrown while copying it leaves the set unchanged.  All
+    // of the nodes are allocated in a single slab.
+    template <typename ForwardIterator>
+    void assign(ForwardIterator first, ForwardIterator last);
+
+
     // add() adds an element to the set.  If the element is already in the set,
     // this function has no effect.  This function always runs in O(log n) time
-    // when there are n elements in the AVL tree.
+    // when there are n elements in the AVL tree.  Given an rvalue, the new
+    // node's element is moved from it rather than copied.
     void add(const ElementType& element) override;
+    void add(ElementType&& element);
+
+
+    // emplace() is like add(), but constructs the element from the given
+    // arguments, directly in a new node.  Since the element has to exist
+    // to be compared, it's constructed even when an equal one is already
+    // in the set, in which case it's destroyed again.
+    template <typename... Args>
+    void emplace(Args&&... args);
+
+
+    // remove() removes an element from the set.  If the element isn't in
+    // the set, this function has no effect.  Only the nodes along the path
+    // from the removed node to the root are rebalanced, so this function
+    // always runs in O(log n) time.  Iterators to other elements stay
+    // valid, since no other element's node is moved or freed.
+    void remove(const ElementType& element);
 
 
     // contains() returns true if the given element is already in the set,
@@ -73,12 +145,26 @@ public:
     bool contains(const ElementType& element) const override;
 
 
+    // containsKey() is like contains(), but looks for an element equal to
+    // a key of some other type, which the Compare object must be able to
+    // compare with elements in either order.
+    template <typename Key>
+    bool containsKey(const Key& key) const;
+
+
     // size() returns the number of elements in the set.
     unsigned int size() const noexcept override;
 
 
+    // modificationCount() returns the number of elements added and removed
+    // since the set was built, counting each assign() as one more change
+    // (see ModificationCounted.hpp).
+    std::uint64_t modificationCount() const noexcept override;
+
+
     // height() returns the height of the AVL tree.  Note that, by definition,
-    // the height of an empty tree is -1.
+    // the height of an empty tree is -1.  This function runs in constant
+    // time, since every node keeps track of its own height.
     int height() const noexcept;
 
 
@@ -99,36 +185,108 @@ public:
     // tree.
     void postorder(VisitFunction visit) const;
 
-    
+
+    // These are like preorder(), inorder() and postorder(), except that
+    // they take any kind of callable object rather than a VisitFunction,
+    // so that the call to it can be inlined.
+    template <typename Visit>
+    void forEachPreorder(Visit&& visit) const;
+
+    template <typename Visit>
+    void forEachInorder(Visit&& visit) const;
+
+    template <typename Visit>
+    void forEachPostorder(Visit&& visit) const;
+
+
+    // begin() and end() return bidirectional iterators that visit the
+    // elements in ascending order.  Adding an element doesn't invalidate
+    // any iterators, though it may change which elements they visit next.
+    const_iterator begin() const noexcept;
+    const_iterator end() const noexcept;
+
+
+    // lower_bound() returns an iterator to the smallest element that is
+    // not less than the given one, upper_bound() returns an iterator to
+    // the smallest element that is greater than it, and equal_range()
+    // returns both.  Any of these is end() if there's no such element.
+    // These functions always run in O(log n) time, and iterating from
+    // them over k elements takes O(k) more.
+    const_iterator lower_bound(const ElementType& element) const;
+    const_iterator upper_bound(const ElementType& element) const;
+    std::pair<const_iterator, const_iterator> equal_range(const ElementType& element) const;
+
+
+    // forEachWithPrefix() calls the given "visit" function, in ascending
+    // order, for each of the elements that begin with the given prefix,
+    // which takes O(log n + k) time when k elements match.  If "visit"
+    // returns a bool, returning false stops the traversal early.  This is
+    // only available when the elements are strings, ordered as usual (see
+    // PrefixScanner.hpp), in which case scanPrefix() does the same for a
+    // caller that only knows the set is a PrefixScanner.
+    template <typename Visit>
+    void forEachWithPrefix(std::string_view prefix, Visit&& visit) const;
+
+    void scanPrefix(std::string_view prefix, const PrefixScanner::PrefixVisitor& visit) const;
+
+
 private:
+    // Every node knows its parent and the height of the subtree rooted at
+    // it, so that an insertion can walk back up to the root, fixing the
+    // heights and rebalancing as it goes, without recursion or searching.
     struct Node
     {
         ElementType value;
         Node* right;
         Node* left;
+        Node* parent;
+        int height;
     };
 
+    NodePool<Node> pool;
     Node* head;
-    int treeHeight;
     unsigned int treeSize;
+    bool shouldBalance;
+    Compare compare;
+    ModificationCounter modifications;
 
     void deleteNode(Node* node);
-    int calculateHeight(Node* node);
     Node* clone(Node* node);
 
+    // findParent() finds the node that an element would be added beneath,
+    // and whether it would be the left child, returning false instead if
+    // an equal element is already in the set.  link() then adds the node
+    // there and rebalances.
+    bool findParent(const ElementType& element, Node*& parent, bool& isLeft) const;
+    void link(Node* node, Node* parent, bool isLeft) noexcept;
+
+    template <typename ForwardIterator>
+    Node* build(ForwardIterator& next, unsigned int count);
+
     /*
     Depth First Traversals: 
     (a) Inorder (Left, Root, Right): node->left, then node->value, last node->right
     (b) Preorder (Root, Left, Right): node->value, node->left, node->right
     (c) Postorder (Left, Right, Root) node->left, node->right, node->value
+
+    Each of the functions below returns the node that comes after (or
+    before) the given one in one of those orders, or nullptr if there
+    isn't one.
     */
 
 
-    void post(VisitFunction visit, Node* node) const;
-    void in(VisitFunction visit, Node* node) const;
-    void pre(VisitFunction visit, Node* node) const;
-    int maxHeight(Node* node) const;
-    int difference(Node* node) const;
+    static Node* leftmost(Node* node) noexcept;
+    static Node* rightmost(Node* node) noexcept;
+    static Node* inorderNext(Node* node) noexcept;
+    static Node* inorderPrevious(Node* node) noexcept;
+    static Node* preorderNext(Node* node) noexcept;
+    static Node* postorderFirst(Node* node) noexcept;
+    static Node* postorderNext(Node* node) noexcept;
+    static int heightOf(Node* node) noexcept;
+    static void updateHeight(Node* node) noexcept;
+    static int difference(Node* node) noexcept;
+    void replaceChild(Node* parent, Node* oldChild, Node* newChild) noexcept;
+    void retrace(Node* node) noexcept;
     Node* rrRotation(Node* parent);
     Node* llRotation(Node* parent);
     Node* lrRotation(Node* parent);
@@ -136,51 +294,167 @@ private:
     Node* balance(Node* T);
 };
 
-template <typename ElementType>
-int AVLSet<ElementType>::maxHeight(Node* node) const
+
+
+template <typename ElementType, typename Compare>
+class AVLSet<ElementType, Compare>::const_iterator
 {
-    int h = 0;
-    if (node != nullptr)
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = ElementType;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const ElementType*;
+    using reference = const ElementType&;
+
+public:
+    const_iterator() noexcept
+        : node{nullptr}, set{nullptr}
     {
-        int l_height = maxHeight(node->left);
-        int r_height = maxHeight(node->right);
-        int max_height = std::max(l_height, r_height);
-        h = max_height + 1;
     }
-    return h;
+
+    reference operator*() const noexcept
+    {
+        return node->value;
+    }
+
+    pointer operator->() const noexcept
+    {
+        return &node->value;
+    }
+
+    const_iterator& operator++() noexcept
+    {
+        node = inorderNext(node);
+        return *this;
+    }
+
+    const_iterator operator++(int) noexcept
+    {
+        const_iterator old = *this;
+        ++*this;
+        return old;
+    }
+
+    // Stepping back from end() lands on the largest element, which is why
+    // an iterator has to know which set it belongs to.
+    const_iterator& operator--() noexcept
+    {
+        node = node == nullptr ? rightmost(set->head) : inorderPrevious(node);
+        return *this;
+    }
+
+    const_iterator operator--(int) noexcept
+    {
+        const_iterator old = *this;
+        --*this;
+        return old;
+    }
+
+    bool operator==(const const_iterator& other) const noexcept
+    {
+        return node == other.node;
+    }
+
+    bool operator!=(const const_iterator& other) const noexcept
+    {
+        return node != other.node;
+    }
+
+private:
+    friend class AVLSet;
+
+    const_iterator(Node* node, const AVLSet* set) noexcept
+        : node{node}, set{set}
+    {
+    }
+
+    Node* node;
+    const AVLSet* set;
+};
+
+template <typename ElementType, typename Compare>
+int AVLSet<ElementType, Compare>::heightOf(Node* node) noexcept
+{
+    return node == nullptr ? -1 : node->height;
+}
+
+template <typename ElementType, typename Compare>
+void AVLSet<ElementType, Compare>::updateHeight(Node* node) noexcept
+{
+    node->height = std::max(heightOf(node->left), heightOf(node->right)) + 1;
 }
 
-template <typename ElementType>
-int AVLSet<ElementType>::difference(Node* node) const
+template <typename ElementType, typename Compare>
+int AVLSet<ElementType, Compare>::difference(Node* node) noexcept
 {
-    int l_height = maxHeight(node->left);
-    int r_height = maxHeight(node->right);
-    int factor = l_height - r_height;
-    return factor;
+    return heightOf(node->left) - heightOf(node->right);
 }
 
-template <typename ElementType>
-typename AVLSet<ElementType>::Node* AVLSet<ElementType>::rrRotation(Node* parent)
+template <typename ElementType, typename Compare>
+void AVLSet<ElementType, Compare>::replaceChild(Node* parent, Node* oldChild, Node* newChild) noexcept
+{
+    if (newChild != nullptr)
+    {
+        newChild->parent = parent;
+    }
+
+    if (parent == nullptr)
+    {
+        head = newChild;
+    }
+    else if (parent->left == oldChild)
+    {
+        parent->left = newChild;
+    }
+    else
+    {
+        parent->right = newChild;
+    }
+}
+
+// The rotations below take the root of a subtree and return the new root
+// of that subtree.  They fix the parent pointers and heights within the
+// subtree, but it's up to the caller to link the new root to the old
+// root's parent (see replaceChild()).
+
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::rrRotation(Node* parent)
 {
     Node* temp;
     temp = parent->right;
     parent->right = temp->left;
+    if (temp->left != nullptr)
+    {
+        temp->left->parent = parent;
+    }
     temp->left = parent;
+    temp->parent = parent->parent;
+    parent->parent = temp;
+    updateHeight(parent);
+    updateHeight(temp);
     return temp;
 }
 
-template <typename ElementType>
-typename AVLSet<ElementType>::Node* AVLSet<ElementType>::llRotation(Node* parent)
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::llRotation(Node* parent)
 {
     Node* temp;
     temp = parent->left;
     parent->left = temp->right;
+    if (temp->right != nullptr)
+    {
+        temp->right->parent = parent;
+    }
     temp->right = parent;
+    temp->parent = parent->parent;
+    parent->parent = temp;
+    updateHeight(parent);
+    updateHeight(temp);
     return temp;
 }
 
-template <typename ElementType>
-typename AVLSet<ElementType>::Node* AVLSet<ElementType>::lrRotation(Node* parent)
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::lrRotation(Node* parent)
 {
     Node* temp;
     temp = parent->left;
@@ -188,8 +462,8 @@ typename AVLSet<ElementType>::Node* AVLSet<ElementType>::lrRotation(Node* parent
     return llRotation(parent);
 }
 
-template <typename ElementType>
-typename AVLSet<ElementType>::Node* AVLSet<ElementType>::rlRotation(Node* parent)
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::rlRotation(Node* parent)
 {
     Node* temp;
     temp = parent->right;
@@ -198,13 +472,13 @@ typename AVLSet<ElementType>::Node* AVLSet<ElementType>::rlRotation(Node* parent
 
 }
 
-template <typename ElementType>
-typename AVLSet<ElementType>::Node* AVLSet<ElementType>::balance(Node* T)
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::balance(Node* T)
 {
     int factor = difference(T);
     if (factor > 1)
     {
-        if (difference(T->left)>0)
+        if (difference(T->left)>=0)
         {
             T = llRotation(T);
         }
@@ -227,148 +501,371 @@ typename AVLSet<ElementType>::Node* AVLSet<ElementType>::balance(Node* T)
     return T;
 }
 
-template <typename ElementType>
-AVLSet<ElementType>::AVLSet(bool shouldBalance)
+template <typename ElementType, typename Compare>
+void AVLSet<ElementType, Compare>::retrace(Node* node) noexcept
+{
+    // Walks from the given node up to the root, fixing the heights along
+    // the way and, if balancing is on, rotating any node that has become
+    // unbalanced.  The walk stops as soon as a subtree's height is the
+    // same as it was before, since nothing above it can have changed.
+    // This works the same way after a removal as after an insertion,
+    // except that a removal may need a rotation at every level.
+    while (node != nullptr)
+    {
+        int oldHeight = node->height;
+        updateHeight(node);
+
+        if (shouldBalance && (difference(node) > 1 || difference(node) < -1))
+        {
+            Node* parent = node->parent;
+            Node* subtree = balance(node);
+            replaceChild(parent, node, subtree);
+            node = subtree;
+        }
+
+        if (node->height == oldHeight)
+        {
+            break;
+        }
+
+        node = node->parent;
+    }
+}
+
+template <typename ElementType, typename Compare>
+AVLSet<ElementType, Compare>::AVLSet(bool shouldBalance)
+    : shouldBalance{shouldBalance}, compare{}
 {
     head = nullptr;
-    treeHeight = -1;
     treeSize = 0;
 }
 
 
-template <typename ElementType>
-AVLSet<ElementType>::~AVLSet() noexcept
+template <typename ElementType, typename Compare>
+AVLSet<ElementType, Compare>::AVLSet(const Compare& compare, bool shouldBalance)
+    : shouldBalance{shouldBalance}, compare{compare}
 {
-    deleteNode(head);
+    head = nullptr;
+    treeSize = 0;
 }
 
 
-template <typename ElementType>
-AVLSet<ElementType>::AVLSet(const AVLSet& s)
+template <typename ElementType, typename Compare>
+template <typename ForwardIterator>
+AVLSet<ElementType, Compare>::AVLSet(ForwardIterator first, ForwardIterator last, bool shouldBalance)
+    : shouldBalance{shouldBalance}, compare{}
 {
     head = nullptr;
-    treeHeight = -1;
     treeSize = 0;
+    assign(first, last);
+}
+
+
+template <typename ElementType, typename Compare>
+AVLSet<ElementType, Compare>::~AVLSet() noexcept
+{
+    deleteNode(head);
+    pool.release();
+}
 
+
+template <typename ElementType, typename Compare>
+AVLSet<ElementType, Compare>::AVLSet(const AVLSet& s)
+    : shouldBalance{s.shouldBalance}, compare{s.compare}
+{
+    pool.reserve(s.treeSize);
     head = clone(s.head);
     treeSize = s.treeSize;
-    treeHeight = s.treeHeight;
 }
 
 
-template <typename ElementType>
-AVLSet<ElementType>::AVLSet(AVLSet&& s) noexcept
+template <typename ElementType, typename Compare>
+AVLSet<ElementType, Compare>::AVLSet(AVLSet&& s) noexcept
+    : shouldBalance{s.shouldBalance}, compare{s.compare}
 {
     head = nullptr;
-    treeHeight = -1;
     treeSize = 0;
+    pool.swap(s.pool);
     std::swap(head, s.head);
     std::swap(treeSize, s.treeSize);
-    std::swap(treeHeight, s.treeHeight);
+    s.modifications.bump();
 }
 
 
-template <typename ElementType>
-AVLSet<ElementType>& AVLSet<ElementType>::operator=(const AVLSet& s)
+template <typename ElementType, typename Compare>
+AVLSet<ElementType, Compare>& AVLSet<ElementType, Compare>::operator=(const AVLSet& s)
 {
     if (this != &s)
     {
-        Node* newHead = clone(s.head);
-        head = newHead;
+        deleteNode(head);
+        pool.release();
+        pool.reserve(s.treeSize);
+        head = clone(s.head);
+        treeSize = s.treeSize;
+        shouldBalance = s.shouldBalance;
+        compare = s.compare;
+        modifications.bump();
     }
-    treeHeight = s.treeHeight;
-    treeSize = s.treeSize;
     return *this;
 }
 
 
-template <typename ElementType>
-AVLSet<ElementType>& AVLSet<ElementType>::operator=(AVLSet&& s) noexcept
+template <typename ElementType, typename Compare>
+AVLSet<ElementType, Compare>& AVLSet<ElementType, Compare>::operator=(AVLSet&& s) noexcept
 {
+    pool.swap(s.pool);
     std::swap(head, s.head);
     std::swap(treeSize, s.treeSize);
-    std::swap(treeHeight, s.treeHeight);
+    std::swap(shouldBalance, s.shouldBalance);
+    std::swap(compare, s.compare);
+    modifications.bump();
+    s.modifications.bump();
     return *this;
 }
 
 
-template <typename ElementType>
-bool AVLSet<ElementType>::isImplemented() const noexcept
+template <typename ElementType, typename Compare>
+bool AVLSet<ElementType, Compare>::isImplemented() const noexcept
 {
     return true;
 }
 
 
-template <typename ElementType>
-void AVLSet<ElementType>::add(const ElementType& element)
+template <typename ElementType, typename Compare>
+template <typename ForwardIterator>
+void AVLSet<ElementType, Compare>::assign(ForwardIterator first, ForwardIterator last)
 {
-    Node* previous;
-    std::string direction;
-    if (treeSize == 0)
+    auto isNotLess = [this](const ElementType& a, const ElementType& b)
     {
-        Node* newNode = new Node();
-        newNode->value = element;
-        newNode->left = nullptr;
-        newNode->right = nullptr;
-        head = newNode;
-        treeHeight = 0;
+        return !compare(a, b);
+    };
+
+    std::vector<ElementType> sorted(first, last);
+
+    if (std::adjacent_find(sorted.begin(), sorted.end(), isNotLess) != sorted.end())
+    {
+        std::sort(sorted.begin(), sorted.end(), compare);
+        sorted.erase(std::unique(sorted.begin(), sorted.end(), isNotLess), sorted.end());
+    }
+
+    deleteNode(head);
+    pool.release();
+    head = nullptr;
+    treeSize = 0;
+    modifications.bump();
+
+    unsigned int count = static_cast<unsigned int>(sorted.size());
+    auto next = std::make_move_iterator(sorted.begin());
+    pool.reserve(count);
+    head = build(next, count);
+    treeSize = count;
+}
+
+
+template <typename ElementType, typename Compare>
+void AVLSet<ElementType, Compare>::add(const ElementType& element)
+{
+    Node* parent;
+    bool isLeft;
+
+    if (findParent(element, parent, isLeft))
+    {
+        link(pool.create(element, nullptr, nullptr, parent, 0), parent, isLeft);
+    }
+}
+
+
+template <typename ElementType, typename Compare>
+void AVLSet<ElementType, Compare>::add(ElementType&& element)
+{
+    Node* parent;
+    bool isLeft;
+
+    if (findParent(element, parent, isLeft))
+    {
+        link(pool.create(std::move(element), nullptr, nullptr, parent, 0), parent, isLeft);
+    }
+}
+
+
+template <typename ElementType, typename Compare>
+template <typename... Args>
+void AVLSet<ElementType, Compare>::emplace(Args&&... args)
+{
+    Node* node = pool.create(
+        InPlace<ElementType, Args...>{std::forward<Args>(args)...}, nullptr, nullptr, nullptr, 0);
+
+    Node* parent;
+    bool isLeft;
+    bool isNew;
+
+    try
+    {
+        isNew = findParent(node->value, parent, isLeft);
+    }
+    catch (...)
+    {
+        pool.destroy(node);
+        throw;
+    }
+
+    if (isNew)
+    {
+        node->parent = parent;
+        link(node, parent, isLeft);
     }
     else
     {
-        Node* current = head;
-        while (current != nullptr)
+        pool.destroy(node);
+    }
+}
+
+
+template <typename ElementType, typename Compare>
+bool AVLSet<ElementType, Compare>::findParent(
+    const ElementType& element, Node*& parent, bool& isLeft) const
+{
+    parent = nullptr;
+    isLeft = false;
+
+    for (Node* current = head; current != nullptr; )
+    {
+        parent = current;
+        if (compare(element, current->value))
         {
-            previous = current;
-            if (current->value > element)
-            {
-                current = current->left;
-                direction = "left";
-            }
-            else if (current->value < element)
-            {
-                current = current->right;
-                direction = "right";
-            }
+            current = current->left;
+            isLeft = true;
         }
-        
-        if (direction == "right")
+        else if (compare(current->value, element))
         {
-            Node* add = new Node();
-            add->value = element;
-            add->left = nullptr;
-            add->right = nullptr;
-            previous->right = add;
+            current = current->right;
+            isLeft = false;
         }
-        else if(direction == "left")
-        {   
-            Node* add = new Node();
-            add->value = element;
-            add->left = nullptr;
-            add->right = nullptr;
-            previous->left = add;
+        else
+        {
+            return false;
         }
     }
-    treeHeight = calculateHeight(head);
+
+    return true;
+}
+
+
+template <typename ElementType, typename Compare>
+void AVLSet<ElementType, Compare>::link(Node* node, Node* parent, bool isLeft) noexcept
+{
+    if (parent == nullptr)
+    {
+        head = node;
+    }
+    else if (isLeft)
+    {
+        parent->left = node;
+    }
+    else
+    {
+        parent->right = node;
+    }
+
     treeSize++;
+    modifications.bump();
+    retrace(parent);
 }
 
 
-template <typename ElementType>
-bool AVLSet<ElementType>::contains(const ElementType& element) const
+template <typename ElementType, typename Compare>
+void AVLSet<ElementType, Compare>::remove(const ElementType& element)
+{
+    Node* remove = head;
+
+    while (remove != nullptr)
+    {
+        if (compare(element, remove->value))
+        {
+            remove = remove->left;
+        }
+        else if (compare(remove->value, element))
+        {
+            remove = remove->right;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (remove == nullptr)
+    {
+        return;
+    }
+
+    // The lowest node whose subtree has changed, where retracing starts.
+    Node* changed;
+
+    if (remove->left == nullptr || remove->right == nullptr)
+    {
+        // With at most one child, that child simply takes the node's place.
+        Node* child = remove->left != nullptr ? remove->left : remove->right;
+        changed = remove->parent;
+        replaceChild(remove->parent, remove, child);
+    }
+    else
+    {
+        // With two children, the node's in-order successor (which has no
+        // left child) is unlinked from where it is and moved into the
+        // node's place, taking over its children and its height.
+        Node* successor = leftmost(remove->right);
+
+        if (successor->parent == remove)
+        {
+            changed = successor;
+        }
+        else
+        {
+            changed = successor->parent;
+            changed->left = successor->right;
+            if (successor->right != nullptr)
+            {
+                successor->right->parent = changed;
+            }
+
+            successor->right = remove->right;
+            remove->right->parent = successor;
+        }
+
+        successor->left = remove->left;
+        remove->left->parent = successor;
+        successor->height = remove->height;
+        replaceChild(remove->parent, remove, successor);
+    }
+
+    pool.destroy(remove);
+    treeSize--;
+    modifications.bump();
+    retrace(changed);
+}
+
+
+template <typename ElementType, typename Compare>
+bool AVLSet<ElementType, Compare>::contains(const ElementType& element) const
+{
+    return containsKey(element);
+}
+
+
+template <typename ElementType, typename Compare>
+template <typename Key>
+bool AVLSet<ElementType, Compare>::containsKey(const Key& key) const
 {
     Node* contain = head;
-    Node* newHead = head;
-    int factor = difference(newHead);
-    std::cout << newHead->left->right->value << "is the last node" << std::endl;
-    std::cout << "The different between is : " << factor << std::endl;
 
     while(contain != nullptr)
     {
-        if (contain->value > element)
+        if (compare(key, contain->value))
         {
             contain = contain->left;
         }
-        else if (contain->value < element)
+        else if (compare(contain->value, key))
         {
             contain = contain->right;
         }
@@ -381,117 +878,412 @@ bool AVLSet<ElementType>::contains(const ElementType& element) const
 }
 
 
-template <typename ElementType>
-unsigned int AVLSet<ElementType>::size() const noexcept
+template <typename ElementType, typename Compare>
+unsigned int AVLSet<ElementType, Compare>::size() const noexcept
 {
     return treeSize;
 }
 
 
-template <typename ElementType>
-int AVLSet<ElementType>::height() const noexcept
+template <typename ElementType, typename Compare>
+std::uint64_t AVLSet<ElementType, Compare>::modificationCount() const noexcept
 {
-    return treeHeight;
+    return modifications.value();
 }
 
 
-template <typename ElementType>
-void AVLSet<ElementType>::preorder(VisitFunction visit) const
+template <typename ElementType, typename Compare>
+int AVLSet<ElementType, Compare>::height() const noexcept
 {
-    pre(visit, head);
+    return heightOf(head);
 }
 
 
-template <typename ElementType>
-void AVLSet<ElementType>::inorder(VisitFunction visit) const
+template <typename ElementType, typename Compare>
+void AVLSet<ElementType, Compare>::preorder(VisitFunction visit) const
 {
-    in(visit, head);
+    forEachPreorder(visit);
 }
 
 
-template <typename ElementType>
-void AVLSet<ElementType>::postorder(VisitFunction visit) const
+template <typename ElementType, typename Compare>
+void AVLSet<ElementType, Compare>::inorder(VisitFunction visit) const
 {
-    post(visit, head);
+    forEachInorder(visit);
 }
 
 
-template <typename ElementType>
-void AVLSet<ElementType>::deleteNode(Node* node)
+template <typename ElementType, typename Compare>
+void AVLSet<ElementType, Compare>::postorder(VisitFunction visit) const
 {
-    if (node != nullptr)
+    forEachPostorder(visit);
+}
+
+
+template <typename ElementType, typename Compare>
+template <typename Visit>
+void AVLSet<ElementType, Compare>::forEachPreorder(Visit&& visit) const
+{
+    for (Node* node = head; node != nullptr; node = preorderNext(node))
     {
-        deleteNode(node->left);
-        deleteNode(node->right);
-        delete node;
+        visit(static_cast<const ElementType&>(node->value));
     }
 }
 
-template <typename ElementType>
-int AVLSet<ElementType>::calculateHeight(Node* node)
+
+template <typename ElementType, typename Compare>
+template <typename Visit>
+void AVLSet<ElementType, Compare>::forEachInorder(Visit&& visit) const
 {
-    if (node == nullptr)
+    for (Node* node = leftmost(head); node != nullptr; node = inorderNext(node))
     {
-        return -1;
+        visit(static_cast<const ElementType&>(node->value));
     }
-    else
+}
+
+
+template <typename ElementType, typename Compare>
+template <typename Visit>
+void AVLSet<ElementType, Compare>::forEachPostorder(Visit&& visit) const
+{
+    for (Node* node = postorderFirst(head); node != nullptr; node = postorderNext(node))
     {
-        int leftDepth = calculateHeight(node->left);
-        int rightDepth = calculateHeight(node->right);
+        visit(static_cast<const ElementType&>(node->value));
+    }
+}
+
+
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::const_iterator AVLSet<ElementType, Compare>::begin() const noexcept
+{
+    return const_iterator{leftmost(head), this};
+}
+
 
-        return std::max(leftDepth, rightDepth)+1;
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::const_iterator AVLSet<ElementType, Compare>::end() const noexcept
+{
+    return const_iterator{nullptr, this};
+}
+
+
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::const_iterator AVLSet<ElementType, Compare>::lower_bound(
+    const ElementType& element) const
+{
+    Node* bound = nullptr;
+
+    for (Node* node = head; node != nullptr; )
+    {
+        if (compare(node->value, element))
+        {
+            node = node->right;
+        }
+        else
+        {
+            bound = node;
+            node = node->left;
+        }
+    }
+
+    return const_iterator{bound, this};
+}
+
+
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::const_iterator AVLSet<ElementType, Compare>::upper_bound(
+    const ElementType& element) const
+{
+    Node* bound = nullptr;
+
+    for (Node* node = head; node != nullptr; )
+    {
+        if (compare(element, node->value))
+        {
+            bound = node;
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
     }
-    
+
+    return const_iterator{bound, this};
+}
+
+
+template <typename ElementType, typename Compare>
+std::pair<typename AVLSet<ElementType, Compare>::const_iterator, typename AVLSet<ElementType, Compare>::const_iterator>
+AVLSet<ElementType, Compare>::equal_range(const ElementType& element) const
+{
+    return {lower_bound(element), upper_bound(element)};
 }
 
-template <typename ElementType>
-typename AVLSet<ElementType>::Node* AVLSet<ElementType>::clone(Node* node)
+
+template <typename ElementType, typename Compare>
+template <typename Visit>
+void AVLSet<ElementType, Compare>::forEachWithPrefix(std::string_view prefix, Visit&& visit) const
 {
+    static_assert(
+        isPrefixScannable<ElementType, Compare>,
+        "forEachWithPrefix() needs an AVLSet of std::strings ordered by std::less");
+
+    // Every element with the prefix is at least the prefix itself, so the
+    // search starts from the prefix's lower bound and stops at the first
+    // element that doesn't begin with it.
+    Node* node = nullptr;
+
+    for (Node* current = head; current != nullptr; )
+    {
+        if (std::string_view{current->value} < prefix)
+        {
+            current = current->right;
+        }
+        else
+        {
+            node = current;
+            current = current->left;
+        }
+    }
+
+    for (; node != nullptr; node = inorderNext(node))
+    {
+        std::string_view value{node->value};
+        if (value.compare(0, prefix.size(), prefix) != 0)
+        {
+            break;
+        }
+
+        if constexpr (std::is_same<decltype(visit(static_cast<const ElementType&>(node->value))), bool>::value)
+        {
+            if (!visit(static_cast<const ElementType&>(node->value)))
+            {
+                break;
+            }
+        }
+        else
+        {
+            visit(static_cast<const ElementType&>(node->value));
+        }
+    }
+}
+
+
+template <typename ElementType, typename Compare>
+void AVLSet<ElementType, Compare>::scanPrefix(
+    std::string_view prefix, const PrefixScanner::PrefixVisitor& visit) const
+{
+    forEachWithPrefix(prefix, visit);
+}
+
+
+template <typename ElementType, typename Compare>
+void AVLSet<ElementType, Compare>::deleteNode(Node* node)
+{
+    // The nodes' space is given back all at once when the pool is
+    // released, so only their destructors need to be run here, and not
+    // even those if there's nothing for them to do.  A postorder walk
+    // reaches every node after its children, so each node's parent is
+    // still intact when we need it to find the next node.
+    if constexpr (!std::is_trivially_destructible<Node>::value)
+    {
+        Node* current = postorderFirst(node);
+        while (current != nullptr && current != node)
+        {
+            Node* next = postorderNext(current);
+            current->~Node();
+            current = next;
+        }
+
+        if (node != nullptr)
+        {
+            node->~Node();
+        }
+    }
+}
+
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::clone(Node* node)
+{
+    // Walks the original tree in preorder, creating each copied node as
+    // soon as its parent exists.  "from" and "to" always point to matching
+    // nodes in the two trees, and a child missing in the copy but present
+    // in the original is one that hasn't been copied yet.
     if (node==nullptr)
     {
         return nullptr;
     }
-    else
+
+    Node* copy = pool.create(node->value, nullptr, nullptr, nullptr, node->height);
+    Node* from = node;
+    Node* to = copy;
+
+    while (true)
+    {
+        if (from->left != nullptr && to->left == nullptr)
+        {
+            from = from->left;
+            to->left = pool.create(from->value, nullptr, nullptr, to, from->height);
+            to = to->left;
+        }
+        else if (from->right != nullptr && to->right == nullptr)
+        {
+            from = from->right;
+            to->right = pool.create(from->value, nullptr, nullptr, to, from->height);
+            to = to->right;
+        }
+        else if (from == node)
+        {
+            return copy;
+        }
+        else
+        {
+            from = from->parent;
+            to = to->parent;
+        }
+    }
+}
+
+template <typename ElementType, typename Compare>
+template <typename ForwardIterator>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::build(ForwardIterator& next, unsigned int count)
+{
+    // Builds a perfectly balanced subtree out of the next count elements,
+    // consuming them in order: first the left half, then the root, then
+    // the right half.  The caller links the root to its parent.
+    if (count == 0)
+    {
+        return nullptr;
+    }
+
+    Node* left = build(next, count / 2);
+    Node* temp = pool.create(*next, nullptr, nullptr, nullptr, 0);
+    ++next;
+    Node* right = build(next, count - count / 2 - 1);
+
+    temp->left = left;
+    temp->right = right;
+    if (left != nullptr)
+    {
+        left->parent = temp;
+    }
+    if (right != nullptr)
     {
-        Node* temp = new Node();
-        temp->value = node->value;
-        temp->right = clone(node->right);
-        temp->left = clone(node->left);
-        return temp;
+        right->parent = temp;
     }
+    updateHeight(temp);
+    return temp;
 }
 
-template <typename ElementType>
-void AVLSet<ElementType>::pre(VisitFunction visit, Node* node) const
+
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::leftmost(Node* node) noexcept
 {
-    if (node != nullptr)
+    while (node != nullptr && node->left != nullptr)
     {
-        visit(node->value);
-        pre(visit, node->left);
-        pre(visit, node->right);
+        node = node->left;
     }
+    return node;
 }
 
-template <typename ElementType>
-void AVLSet<ElementType>::post(VisitFunction visit, Node* node) const
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::rightmost(Node* node) noexcept
 {
-    if (node != nullptr)
+    while (node != nullptr && node->right != nullptr)
     {
-        post(visit, node->left);
-        post(visit, node->right);
-        visit(node->value);
+        node = node->right;
     }
+    return node;
 }
 
-template <typename ElementType>
-void AVLSet<ElementType>::in(VisitFunction visit, Node* node) const
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::inorderNext(Node* node) noexcept
 {
-    if (node != nullptr)
+    if (node->right != nullptr)
+    {
+        return leftmost(node->right);
+    }
+
+    while (node->parent != nullptr && node->parent->right == node)
     {
-        in(visit, node->left);
-        visit(node->value);
-        in(visit, node->right);
+        node = node->parent;
     }
+    return node->parent;
 }
-#endif
 
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::inorderPrevious(Node* node) noexcept
+{
+    if (node->left != nullptr)
+    {
+        return rightmost(node->left);
+    }
+
+    while (node->parent != nullptr && node->parent->left == node)
+    {
+        node = node->parent;
+    }
+    return node->parent;
+}
+
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::preorderNext(Node* node) noexcept
+{
+    if (node->left != nullptr)
+    {
+        return node->left;
+    }
+    if (node->right != nullptr)
+    {
+        return node->right;
+    }
+
+    // A leaf is followed by the right child of the nearest ancestor whose
+    // left subtree we've just finished, if it has one.
+    while (node->parent != nullptr)
+    {
+        Node* parent = node->parent;
+        if (parent->left == node && parent->right != nullptr)
+        {
+            return parent->right;
+        }
+        node = parent;
+    }
+    return nullptr;
+}
+
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::postorderFirst(Node* node) noexcept
+{
+    // The first node in postorder is the leaf reached by always going
+    // left when possible and right otherwise.
+    while (node != nullptr)
+    {
+        if (node->left != nullptr)
+        {
+            node = node->left;
+        }
+        else if (node->right != nullptr)
+        {
+            node = node->right;
+        }
+        else
+        {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+template <typename ElementType, typename Compare>
+typename AVLSet<ElementType, Compare>::Node* AVLSet<ElementType, Compare>::postorderNext(Node* node) noexcept
+{
+    Node* parent = node->parent;
+    if (parent != nullptr && parent->left == node && parent->right != nullptr)
+    {
+        return postorderFirst(parent->right);
+    }
+    return parent;
+}
+#endif
@@ -0,0 +1,861 @@
+// BPlusTreeSet.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A BPlusTreeSet is an implementation of a Set that is a B+-tree: an
+// ordered search tree whose nodes each hold many elements, in an array,
+// rather than one.  Every element is stored in a "leaf" at the bottom of
+// the tree, and the leaves are linked together in ascending order.  The
+// "internal" nodes above them hold only copies of some of the elements,
+// which are used as separators to decide which child to descend into.
+//
+// Since every node is about NodeBytes in size (512 by default), a lookup
+// reads a few nodes of several cache lines each, searching each one with
+// a binary search through a contiguous array, rather than reading one
+// node per comparison as an AVLSet does.  With the default node size and
+// std::string elements, each node holds 15 elements, so a tree of a
+// million words is only 6 levels deep.  Scanning the elements in order
+// just follows the leaves from one to the next.
+//
+// Every node is always at least half full, except possibly the root, and
+// every leaf is at the same depth, so the tree is always balanced.  The
+// elements must be default-constructible and move-assignable, since the
+// arrays in the nodes are made of elements rather than raw space.
+//
+// The nodes are allocated from NodePools (see NodePool.hpp), one for the
+// leaves and one for the internal nodes.
+
+#ifndef BPLUSTREESET_HPP
+#define BPLUSTREESET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "ModificationCounted.hpp"
+#include "NodePool.hpp"
+#include "PrefixScanner.hpp"
+#include "Set.hpp"
+
+
+
+template <typename ElementType, unsigned int NodeBytes = 512>
+class BPlusTreeSet
+    : public Set<ElementType>, public ModificationCounted,
+      public PrefixScannerBase<ElementType>
+{
+private:
+    // Every node starts with the number of elements (or separators) in it.
+    struct Node
+    {
+        unsigned int count;
+    };
+
+    struct Leaf;
+    struct Internal;
+
+public:
+    // The number of elements that fit in a leaf, and the number of
+    // separators that fit in an internal node (which has one more child
+    // than it has separators), so that each kind of node is about
+    // NodeBytes in size.
+    static constexpr unsigned int LEAF_CAPACITY = std::max<std::size_t>(
+        3, (NodeBytes - sizeof(Node) - 2 * sizeof(void*)) / sizeof(ElementType));
+
+    static constexpr unsigned int INTERNAL_CAPACITY = std::max<std::size_t>(
+        3, (NodeBytes - sizeof(Node) - sizeof(void*)) / (sizeof(ElementType) + sizeof(void*)));
+
+    // A VisitFunction is a function that takes a reference to a const
+    // ElementType and returns no value.
+    using VisitFunction = std::function<void(const ElementType&)>;
+
+    class const_iterator;
+    using iterator = const_iterator;
+
+public:
+    // Initializes a BPlusTreeSet to be empty.
+    BPlusTreeSet() noexcept;
+
+    // Cleans up the BPlusTreeSet so that it leaks no memory.
+    ~BPlusTreeSet() noexcept override;
+
+    // Initializes a new BPlusTreeSet to be a copy of an existing one.
+    BPlusTreeSet(const BPlusTreeSet& s);
+
+    // Initializes a new BPlusTreeSet whose contents are moved from an
+    // expiring one.
+    BPlusTreeSet(BPlusTreeSet&& s) noexcept;
+
+    // Assigns an existing BPlusTreeSet into another.
+    BPlusTreeSet& operator=(const BPlusTreeSet& s);
+
+    // Assigns an expiring BPlusTreeSet into another.
+    BPlusTreeSet& operator=(BPlusTreeSet&& s) noexcept;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() adds an element to the set.  If the element is already in the
+    // set, this function has no effect.  A full node is split in two,
+    // which may split its parent in turn, all the way up to the root.
+    // This function always runs in O(log n) time.
+    void add(const ElementType& element) override;
+
+
+    // contains() returns true if the given element is already in the set,
+    // false otherwise.  This function always runs in O(log n) time.
+    bool contains(const ElementType& element) const override;
+
+
+    // size() returns the number of elements in the set.
+    unsigned int size() const noexcept override;
+
+
+    // modificationCount() returns the number of elements added since the
+    // set was built (see ModificationCounted.hpp).
+    std::uint64_t modificationCount() const noexcept override;
+
+
+    // height() returns the number of levels of internal nodes above the
+    // leaves, or -1 if the set is empty.
+    int height() const noexcept;
+
+
+    // inorder() calls the given "visit" function for each of the elements
+    // in the set, in ascending order.  forEachInorder() does the same with
+    // any kind of callable object, so that the call to it can be inlined.
+    // Since every element is in a leaf, these are the only traversals that
+    // make sense for a B+-tree, and they never visit an internal node.
+    void inorder(VisitFunction visit) const;
+
+    template <typename Visit>
+    void forEachInorder(Visit&& visit) const;
+
+
+    // begin() and end() return bidirectional iterators that visit the
+    // elements in ascending order.  Adding an element invalidates every
+    // iterator, since elements move within and between leaves.
+    const_iterator begin() const noexcept;
+    const_iterator end() const noexcept;
+
+
+    // lower_bound(), upper_bound() and equal_range() are as in AVLSet, and
+    // also run in O(log n) time.
+    const_iterator lower_bound(const ElementType& element) const;
+    const_iterator upper_bound(const ElementType& element) const;
+    std::pair<const_iterator, const_iterator> equal_range(const ElementType& element) const;
+
+
+    // forEachWithPrefix() calls the given "visit" function, in ascending
+    // order, for each of the elements that begin with the given prefix,
+    // which takes O(log n + k) time when k elements match.  If "visit"
+    // returns a bool, returning false stops the traversal early.  This is
+    // only available when the elements are strings, in which case
+    // scanPrefix() does the same for a caller that only knows the set is a
+    // PrefixScanner (see PrefixScanner.hpp).
+    template <typename Visit>
+    void forEachWithPrefix(std::string_view prefix, Visit&& visit) const;
+
+    void scanPrefix(std::string_view prefix, const PrefixScanner::PrefixVisitor& visit) const;
+
+
+private:
+    // The elements of a leaf are in ascending order, and the leaves are
+    // linked in ascending order in both directions.
+    struct Leaf : Node
+    {
+        ElementType elements[LEAF_CAPACITY];
+        Leaf* previous;
+        Leaf* next;
+    };
+
+    // An internal node with count separators has count + 1 children.
+    // Every element under children[i] is less than separators[i], and
+    // every element under children[i + 1] is at least separators[i].
+    struct Internal : Node
+    {
+        ElementType separators[INTERNAL_CAPACITY];
+        Node* children[INTERNAL_CAPACITY + 1];
+    };
+
+    // The most levels a tree can have: even with the minimum of two
+    // children per internal node, 2^64 elements would need fewer.
+    static constexpr unsigned int MAX_LEVELS = 64;
+
+    NodePool<Leaf> leafPool;
+    NodePool<Internal> internalPool;
+    Node* root;
+    Leaf* firstLeaf;
+    Leaf* lastLeaf;
+    unsigned int treeSize;
+    ModificationCounter modifications;
+
+    // The number of levels of internal nodes, so that the nodes at any
+    // depth are known to be leaves or internal nodes.
+    unsigned int levels;
+
+    Leaf* createLeaf();
+    Internal* createInternal();
+    Leaf* findLeaf(const ElementType& element) const;
+    const_iterator iteratorAt(Leaf* leaf, unsigned int index) const noexcept;
+    void destroy(Node* node, unsigned int level) noexcept;
+    Node* clone(const Node* node, unsigned int level, Leaf*& previousLeaf);
+    void copyFrom(const BPlusTreeSet& s);
+    void reset() noexcept;
+};
+
+
+
+template <typename ElementType, unsigned int NodeBytes>
+class BPlusTreeSet<ElementType, NodeBytes>::const_iterator
+{
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = ElementType;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const ElementType*;
+    using reference = const ElementType&;
+
+public:
+    const_iterator() noexcept
+        : leaf{nullptr}, index{0}, set{nullptr}
+    {
+    }
+
+    reference operator*() const noexcept
+    {
+        return leaf->elements[index];
+    }
+
+    pointer operator->() const noexcept
+    {
+        return &leaf->elements[index];
+    }
+
+    const_iterator& operator++() noexcept
+    {
+        if (++index == leaf->count)
+        {
+            leaf = leaf->next;
+            index = 0;
+        }
+        return *this;
+    }
+
+    const_iterator operator++(int) noexcept
+    {
+        const_iterator old = *this;
+        ++*this;
+        return old;
+    }
+
+    // Stepping back from end() lands on the largest element, which is why
+    // an iterator has to know which set it belongs to.
+    const_iterator& operator--() noexcept
+    {
+        if (leaf == nullptr)
+        {
+            leaf = set->lastLeaf;
+            index = leaf->count - 1;
+        }
+        else if (index == 0)
+        {
+            leaf = leaf->previous;
+            index = leaf->count - 1;
+        }
+        else
+        {
+            --index;
+        }
+        return *this;
+    }
+
+    const_iterator operator--(int) noexcept
+    {
+        const_iterator old = *this;
+        --*this;
+        return old;
+    }
+
+    bool operator==(const const_iterator& other) const noexcept
+    {
+        return leaf == other.leaf && index == other.index;
+    }
+
+    bool operator!=(const const_iterator& other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+private:
+    friend class BPlusTreeSet;
+
+    const_iterator(Leaf* leaf, unsigned int index, const BPlusTreeSet* set) noexcept
+        : leaf{leaf}, index{index}, set{set}
+    {
+    }
+
+    Leaf* leaf;
+    unsigned int index;
+    const BPlusTreeSet* set;
+};
+
+
+
+template <typename ElementType, unsigned int NodeBytes>
+BPlusTreeSet<ElementType, NodeBytes>::BPlusTreeSet() noexcept
+    : root{nullptr}, firstLeaf{nullptr}, lastLeaf{nullptr}, treeSize{0}, levels{0}
+{
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+BPlusTreeSet<ElementType, NodeBytes>::~BPlusTreeSet() noexcept
+{
+    destroy(root, levels);
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+BPlusTreeSet<ElementType, NodeBytes>::BPlusTreeSet(const BPlusTreeSet& s)
+    : BPlusTreeSet()
+{
+    copyFrom(s);
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+BPlusTreeSet<ElementType, NodeBytes>::BPlusTreeSet(BPlusTreeSet&& s) noexcept
+    : BPlusTreeSet()
+{
+    *this = std::move(s);
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+BPlusTreeSet<ElementType, NodeBytes>& BPlusTreeSet<ElementType, NodeBytes>::operator=(const BPlusTreeSet& s)
+{
+    if (this != &s)
+    {
+        destroy(root, levels);
+        reset();
+        modifications.bump();
+        copyFrom(s);
+    }
+    return *this;
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+BPlusTreeSet<ElementType, NodeBytes>& BPlusTreeSet<ElementType, NodeBytes>::operator=(BPlusTreeSet&& s) noexcept
+{
+    leafPool.swap(s.leafPool);
+    internalPool.swap(s.internalPool);
+    std::swap(root, s.root);
+    std::swap(firstLeaf, s.firstLeaf);
+    std::swap(lastLeaf, s.lastLeaf);
+    std::swap(treeSize, s.treeSize);
+    std::swap(levels, s.levels);
+    modifications.bump();
+    s.modifications.bump();
+    return *this;
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+bool BPlusTreeSet<ElementType, NodeBytes>::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+void BPlusTreeSet<ElementType, NodeBytes>::add(const ElementType& element)
+{
+    if (root == nullptr)
+    {
+        Leaf* leaf = createLeaf();
+        leaf->elements[0] = element;
+        leaf->count = 1;
+        root = firstLeaf = lastLeaf = leaf;
+        treeSize = 1;
+        modifications.bump();
+        return;
+    }
+
+    // The descent remembers each internal node it passes through and which
+    // child it took, so that splits can be carried back up without parent
+    // pointers.
+    Internal* path[MAX_LEVELS];
+    unsigned int taken[MAX_LEVELS];
+    Node* node = root;
+
+    for (unsigned int level = 0; level < levels; ++level)
+    {
+        Internal* internal = static_cast<Internal*>(node);
+        unsigned int i = static_cast<unsigned int>(
+            std::upper_bound(internal->separators, internal->separators + internal->count, element)
+            - internal->separators);
+        path[level] = internal;
+        taken[level] = i;
+        node = internal->children[i];
+    }
+
+    Leaf* leaf = static_cast<Leaf*>(node);
+    unsigned int position = static_cast<unsigned int>(
+        std::lower_bound(leaf->elements, leaf->elements + leaf->count, element) - leaf->elements);
+
+    if (position < leaf->count && !(element < leaf->elements[position]))
+    {
+        return;
+    }
+
+    if (leaf->count < LEAF_CAPACITY)
+    {
+        std::move_backward(leaf->elements + position, leaf->elements + leaf->count, leaf->elements + leaf->count + 1);
+        leaf->elements[position] = element;
+        leaf->count += 1;
+        treeSize += 1;
+        modifications.bump();
+        return;
+    }
+
+    // The leaf is full, so the upper half of its elements move to a new
+    // leaf to its right, and the new element goes into whichever half it
+    // belongs in.  The new leaf's smallest element becomes the separator
+    // between the two in their parent.
+    Leaf* right = createLeaf();
+    unsigned int half = (LEAF_CAPACITY + 1) / 2;
+
+    std::move(leaf->elements + half, leaf->elements + LEAF_CAPACITY, right->elements);
+    right->count = LEAF_CAPACITY - half;
+    leaf->count = half;
+
+    Leaf* target = position <= half ? leaf : right;
+    unsigned int targetPosition = position <= half ? position : position - half;
+    std::move_backward(
+        target->elements + targetPosition, target->elements + target->count,
+        target->elements + target->count + 1);
+    target->elements[targetPosition] = element;
+    target->count += 1;
+    treeSize += 1;
+    modifications.bump();
+
+    right->previous = leaf;
+    right->next = leaf->next;
+    if (leaf->next != nullptr)
+    {
+        leaf->next->previous = right;
+    }
+    else
+    {
+        lastLeaf = right;
+    }
+    leaf->next = right;
+
+    ElementType separator = right->elements[0];
+    Node* newChild = right;
+
+    // Each parent takes the new separator and child, splitting in turn if
+    // it's full: the separators and children are gathered into one longer
+    // sequence, the lower half stays, the middle separator moves up to the
+    // next parent, and the upper half moves to a new internal node.
+    for (unsigned int level = levels; level > 0; --level)
+    {
+        Internal* parent = path[level - 1];
+        unsigned int i = taken[level - 1];
+
+        if (parent->count < INTERNAL_CAPACITY)
+        {
+            std::move_backward(
+                parent->separators + i, parent->separators + parent->count,
+                parent->separators + parent->count + 1);
+            std::move_backward(
+                parent->children + i + 1, parent->children + parent->count + 1,
+                parent->children + parent->count + 2);
+            parent->separators[i] = std::move(separator);
+            parent->children[i + 1] = newChild;
+            parent->count += 1;
+            return;
+        }
+
+        ElementType separators[INTERNAL_CAPACITY + 1];
+        Node* children[INTERNAL_CAPACITY + 2];
+
+        std::move(parent->separators, parent->separators + i, separators);
+        separators[i] = std::move(separator);
+        std::move(parent->separators + i, parent->separators + INTERNAL_CAPACITY, separators + i + 1);
+
+        std::copy(parent->children, parent->children + i + 1, children);
+        children[i + 1] = newChild;
+        std::copy(parent->children + i + 1, parent->children + INTERNAL_CAPACITY + 1, children + i + 2);
+
+        Internal* sibling = createInternal();
+        unsigned int middle = (INTERNAL_CAPACITY + 1) / 2;
+
+        std::move(separators, separators + middle, parent->separators);
+        std::copy(children, children + middle + 1, parent->children);
+        parent->count = middle;
+
+        std::move(separators + middle + 1, separators + INTERNAL_CAPACITY + 1, sibling->separators);
+        std::copy(children + middle + 1, children + INTERNAL_CAPACITY + 2, sibling->children);
+        sibling->count = INTERNAL_CAPACITY - middle;
+
+        separator = std::move(separators[middle]);
+        newChild = sibling;
+    }
+
+    // The root itself was split, so a new root goes above it.
+    Internal* newRoot = createInternal();
+    newRoot->separators[0] = std::move(separator);
+    newRoot->children[0] = root;
+    newRoot->children[1] = newChild;
+    newRoot->count = 1;
+    root = newRoot;
+    levels += 1;
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+bool BPlusTreeSet<ElementType, NodeBytes>::contains(const ElementType& element) const
+{
+    Leaf* leaf = findLeaf(element);
+
+    if (leaf == nullptr)
+    {
+        return false;
+    }
+
+    const ElementType* position = std::lower_bound(leaf->elements, leaf->elements + leaf->count, element);
+    return position != leaf->elements + leaf->count && !(element < *position);
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+unsigned int BPlusTreeSet<ElementType, NodeBytes>::size() const noexcept
+{
+    return treeSize;
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+std::uint64_t BPlusTreeSet<ElementType, NodeBytes>::modificationCount() const noexcept
+{
+    return modifications.value();
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+int BPlusTreeSet<ElementType, NodeBytes>::height() const noexcept
+{
+    return root == nullptr ? -1 : static_cast<int>(levels);
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+void BPlusTreeSet<ElementType, NodeBytes>::inorder(VisitFunction visit) const
+{
+    forEachInorder(visit);
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+template <typename Visit>
+void BPlusTreeSet<ElementType, NodeBytes>::forEachInorder(Visit&& visit) const
+{
+    for (Leaf* leaf = firstLeaf; leaf != nullptr; leaf = leaf->next)
+    {
+        for (unsigned int i = 0; i < leaf->count; ++i)
+        {
+            visit(static_cast<const ElementType&>(leaf->elements[i]));
+        }
+    }
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+typename BPlusTreeSet<ElementType, NodeBytes>::const_iterator
+BPlusTreeSet<ElementType, NodeBytes>::begin() const noexcept
+{
+    return const_iterator{firstLeaf, 0, this};
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+typename BPlusTreeSet<ElementType, NodeBytes>::const_iterator
+BPlusTreeSet<ElementType, NodeBytes>::end() const noexcept
+{
+    return const_iterator{nullptr, 0, this};
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+typename BPlusTreeSet<ElementType, NodeBytes>::const_iterator
+BPlusTreeSet<ElementType, NodeBytes>::lower_bound(const ElementType& element) const
+{
+    Leaf* leaf = findLeaf(element);
+
+    if (leaf == nullptr)
+    {
+        return end();
+    }
+
+    unsigned int index = static_cast<unsigned int>(
+        std::lower_bound(leaf->elements, leaf->elements + leaf->count, element) - leaf->elements);
+    return iteratorAt(leaf, index);
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+typename BPlusTreeSet<ElementType, NodeBytes>::const_iterator
+BPlusTreeSet<ElementType, NodeBytes>::upper_bound(const ElementType& element) const
+{
+    Leaf* leaf = findLeaf(element);
+
+    if (leaf == nullptr)
+    {
+        return end();
+    }
+
+    unsigned int index = static_cast<unsigned int>(
+        std::upper_bound(leaf->elements, leaf->elements + leaf->count, element) - leaf->elements);
+    return iteratorAt(leaf, index);
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+std::pair<
+    typename BPlusTreeSet<ElementType, NodeBytes>::const_iterator,
+    typename BPlusTreeSet<ElementType, NodeBytes>::const_iterator>
+BPlusTreeSet<ElementType, NodeBytes>::equal_range(const ElementType& element) const
+{
+    return {lower_bound(element), upper_bound(element)};
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+template <typename Visit>
+void BPlusTreeSet<ElementType, NodeBytes>::forEachWithPrefix(std::string_view prefix, Visit&& visit) const
+{
+    // This descends like lower_bound(), but compares the prefix as a
+    // std::string_view, so that it doesn't have to be made into an
+    // ElementType first.
+    Node* node = root;
+    if (node == nullptr)
+    {
+        return;
+    }
+
+    for (unsigned int level = 0; level < levels; ++level)
+    {
+        Internal* internal = static_cast<Internal*>(node);
+        unsigned int i = 0;
+        while (i < internal->count && !(prefix < std::string_view{internal->separators[i]}))
+        {
+            ++i;
+        }
+        node = internal->children[i];
+    }
+
+    Leaf* leaf = static_cast<Leaf*>(node);
+    unsigned int index = 0;
+    while (index < leaf->count && std::string_view{leaf->elements[index]} < prefix)
+    {
+        ++index;
+    }
+
+    for (const_iterator i = iteratorAt(leaf, index); i != end(); ++i)
+    {
+        std::string_view value{*i};
+        if (value.compare(0, prefix.size(), prefix) != 0)
+        {
+            break;
+        }
+
+        if constexpr (std::is_same<decltype(visit(*i)), bool>::value)
+        {
+            if (!visit(*i))
+            {
+                break;
+            }
+        }
+        else
+        {
+            visit(*i);
+        }
+    }
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+void BPlusTreeSet<ElementType, NodeBytes>::scanPrefix(
+    std::string_view prefix, const PrefixScanner::PrefixVisitor& visit) const
+{
+    forEachWithPrefix(prefix, visit);
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+typename BPlusTreeSet<ElementType, NodeBytes>::Leaf* BPlusTreeSet<ElementType, NodeBytes>::createLeaf()
+{
+    Leaf* leaf = leafPool.create();
+    leaf->count = 0;
+    leaf->previous = nullptr;
+    leaf->next = nullptr;
+    return leaf;
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+typename BPlusTreeSet<ElementType, NodeBytes>::Internal* BPlusTreeSet<ElementType, NodeBytes>::createInternal()
+{
+    Internal* internal = internalPool.create();
+    internal->count = 0;
+    return internal;
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+typename BPlusTreeSet<ElementType, NodeBytes>::Leaf* BPlusTreeSet<ElementType, NodeBytes>::findLeaf(
+    const ElementType& element) const
+{
+    // An element equal to a separator is in the child to its right, so
+    // the child to take is the one after every separator that isn't
+    // greater than the element.
+    Node* node = root;
+    if (node == nullptr)
+    {
+        return nullptr;
+    }
+
+    for (unsigned int level = 0; level < levels; ++level)
+    {
+        Internal* internal = static_cast<Internal*>(node);
+        unsigned int i = static_cast<unsigned int>(
+            std::upper_bound(internal->separators, internal->separators + internal->count, element)
+            - internal->separators);
+        node = internal->children[i];
+    }
+
+    return static_cast<Leaf*>(node);
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+typename BPlusTreeSet<ElementType, NodeBytes>::const_iterator
+BPlusTreeSet<ElementType, NodeBytes>::iteratorAt(Leaf* leaf, unsigned int index) const noexcept
+{
+    // A position just past the end of a leaf is the start of the next one.
+    if (index == leaf->count)
+    {
+        return const_iterator{leaf->next, 0, this};
+    }
+
+    return const_iterator{leaf, index, this};
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+void BPlusTreeSet<ElementType, NodeBytes>::destroy(Node* node, unsigned int level) noexcept
+{
+    // The nodes' space is given back when the pools are released, so only
+    // their destructors need to be run here.  The recursion is only as
+    // deep as the tree, which is never more than a handful of levels.
+    if constexpr (!std::is_trivially_destructible<ElementType>::value)
+    {
+        if (node == nullptr)
+        {
+            return;
+        }
+
+        if (level == 0)
+        {
+            static_cast<Leaf*>(node)->~Leaf();
+        }
+        else
+        {
+            Internal* internal = static_cast<Internal*>(node);
+            for (unsigned int i = 0; i <= internal->count; ++i)
+            {
+                destroy(internal->children[i], level - 1);
+            }
+            internal->~Internal();
+        }
+    }
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+typename BPlusTreeSet<ElementType, NodeBytes>::Node* BPlusTreeSet<ElementType, NodeBytes>::clone(
+    const Node* node, unsigned int level, Leaf*& previousLeaf)
+{
+    // The leaves are copied from left to right, so each one is linked to
+    // the one copied just before it.
+    if (level == 0)
+    {
+        const Leaf* from = static_cast<const Leaf*>(node);
+        Leaf* to = createLeaf();
+        std::copy(from->elements, from->elements + from->count, to->elements);
+        to->count = from->count;
+
+        to->previous = previousLeaf;
+        if (previousLeaf != nullptr)
+        {
+            previousLeaf->next = to;
+        }
+        else
+        {
+            firstLeaf = to;
+        }
+        previousLeaf = to;
+        return to;
+    }
+
+    const Internal* from = static_cast<const Internal*>(node);
+    Internal* to = createInternal();
+    std::copy(from->separators, from->separators + from->count, to->separators);
+    to->count = from->count;
+
+    for (unsigned int i = 0; i <= from->count; ++i)
+    {
+        to->children[i] = clone(from->children[i], level - 1, previousLeaf);
+    }
+
+    return to;
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+void BPlusTreeSet<ElementType, NodeBytes>::copyFrom(const BPlusTreeSet& s)
+{
+    if (s.root != nullptr)
+    {
+        Leaf* previousLeaf = nullptr;
+        root = clone(s.root, s.levels, previousLeaf);
+        lastLeaf = previousLeaf;
+        treeSize = s.treeSize;
+        levels = s.levels;
+    }
+}
+
+
+template <typename ElementType, unsigned int NodeBytes>
+void BPlusTreeSet<ElementType, NodeBytes>::reset() noexcept
+{
+    leafPool.release();
+    internalPool.release();
+    root = nullptr;
+    firstLeaf = nullptr;
+    lastLeaf = nullptr;
+    treeSize = 0;
+    levels = 0;
+}
+
+
+
+#endif
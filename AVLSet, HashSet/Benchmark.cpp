@@ -0,0 +1,1971 @@
+// Benchmark.cpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A benchmark harness comparing the Set implementations on the kinds of
+// work a spell checker does with a dictionary.  It's built as its own
+// executable, alongside the rest of the project's code:
+//
+//     g++ -std=c++17 -O2 -pthread -o benchmark Benchmark.cpp BloomFilter.cpp InternedAVLSet.cpp InternedHashSet.cpp MappedWordSet.cpp SpellCheckStream.cpp StringArena.cpp SuggestionCache.cpp SuggestionIndex.cpp TrieSet.cpp WordChecker.cpp
+//
+// and run as
+//
+//     ./benchmark [--words FILE] [--count N] [--filter TEXT] [--json]
+//
+// where FILE holds one dictionary word per line (by default, N random
+// words are generated instead), TEXT limits the run to workloads whose
+// names contain it, and --json switches the output from a table to one
+// JSON object per line, so that results can be saved and compared
+// between runs.
+//
+// Every result reports the average time per operation, the 50th, 90th
+// and 99th percentile and maximum time of a single operation (with the
+// cost of reading the clock subtracted), the number and total size of
+// the heap allocations made while it ran, and the peak resident set size
+// of the process so far.  Workloads that measure throughput across
+// several threads report only the average.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <sys/resource.h>
+#include "AVLSet.hpp"
+#include "BPlusTreeSet.hpp"
+#include "BloomFilter.hpp"
+#include "ConcurrentHashSet.hpp"
+#include "FlatHashSet.hpp"
+#include "FrozenSet.hpp"
+#include "HashSet.hpp"
+#include "InternedAVLSet.hpp"
+#include "InternedHashSet.hpp"
+#include "MappedWordSet.hpp"
+#include "SpellCheckStream.hpp"
+#include "StringArena.hpp"
+#include "SuggestionCache.hpp"
+#include "SuggestionIndex.hpp"
+#include "TrieSet.hpp"
+#include "WordChecker.hpp"
+
+
+
+// Every allocation made by the process goes through these, so that each
+// workload can report how many allocations it made and how many bytes
+// they asked for.
+
+namespace
+{
+    std::atomic<unsigned long long> allocationCount{0};
+    std::atomic<unsigned long long> allocationBytes{0};
+}
+
+
+// Pairing malloc() with free() below is deliberate, though GCC flags it once inlined.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+
+    throw std::bad_alloc{};
+}
+
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align))
+    {
+        return p;
+    }
+
+    throw std::bad_alloc{};
+}
+
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+
+#pragma GCC diagnostic pop
+
+
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+
+    struct Options
+    {
+        std::string wordsPath;
+        std::size_t count = 200000;
+        std::string filter;
+        bool json = false;
+    };
+
+
+    struct Result
+    {
+        std::string workload;
+        std::string set;
+        std::string parameter;
+        std::size_t operations = 0;
+        double nsPerOperation = 0.0;
+        double p50 = 0.0;
+        double p90 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+        unsigned long long allocations = 0;
+        unsigned long long allocatedBytes = 0;
+        long peakRssKb = 0;
+    };
+
+
+    long peakRssKb()
+    {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+
+    class Reporter
+    {
+    public:
+        Reporter(const Options& options)
+            : options{options}, headerPrinted{false}
+        {
+        }
+
+        bool wants(const std::string& workload) const
+        {
+            return options.filter.empty() || workload.find(options.filter) != std::string::npos;
+        }
+
+        void report(const Result& r)
+        {
+            if (options.json)
+            {
+                std::printf(
+                    "{\"workload\":\"%s\",\"set\":\"%s\",\"parameter\":\"%s\","
+                    "\"operations\":%zu,\"ns_per_op\":%.2f,\"p50_ns\":%.1f,"
+                    "\"p90_ns\":%.1f,\"p99_ns\":%.1f,\"max_ns\":%.1f,"
+                    "\"allocations\":%llu,\"allocated_bytes\":%llu,\"peak_rss_kb\":%ld}\n",
+                    r.workload.c_str(), r.set.c_str(), r.parameter.c_str(),
+                    r.operations, r.nsPerOperation, r.p50, r.p90, r.p99, r.max,
+                    r.allocations, r.allocatedBytes, r.peakRssKb);
+            }
+            else
+            {
+                if (!headerPrinted)
+                {
+                    std::printf(
+                        "%-22s %-22s %-14s %10s %10s %9s %9s %9s %11s %11s %13s %10s\n",
+                        "workload", "set", "parameter", "ops", "ns/op", "p50",
+                        "p90", "p99", "max", "allocs", "bytes", "rss(KB)");
+                    headerPrinted = true;
+                }
+
+                std::printf(
+                    "%-22s %-22s %-14s %10zu %10.1f %9.0f %9.0f %9.0f %11.0f %11llu %13llu %10ld\n",
+                    r.workload.c_str(), r.set.c_str(), r.parameter.c_str(),
+                    r.operations, r.nsPerOperation, r.p50, r.p90, r.p99, r.max,
+                    r.allocations, r.allocatedBytes, r.peakRssKb);
+            }
+
+            std::fflush(stdout);
+        }
+
+    private:
+        const Options& options;
+        bool headerPrinted;
+    };
+
+
+    // The cost of one pair of calls to Clock::now(), which is subtracted
+    // from every timed operation.
+    double clockOverhead()
+    {
+        static double overhead = -1.0;
+
+        if (overhead < 0.0)
+        {
+            std::vector<double> samples(10000);
+            for (double& sample: samples)
+            {
+                Clock::time_point start = Clock::now();
+                Clock::time_point end = Clock::now();
+                sample = std::chrono::duration<double, std::nano>(end - start).count();
+            }
+            std::sort(samples.begin(), samples.end());
+            overhead = samples[samples.size() / 2];
+        }
+
+        return overhead;
+    }
+
+
+    // measure() calls operation(i) for every i from 0 to count - 1, timing
+    // each call separately, and returns the statistics for the lot.
+    template <typename Operation>
+    Result measure(
+        const std::string& workload, const std::string& set,
+        const std::string& parameter, std::size_t count, Operation&& operation)
+    {
+        std::vector<double> samples(count);
+        double overhead = clockOverhead();
+
+        unsigned long long allocationsBefore = allocationCount.load();
+        unsigned long long bytesBefore = allocationBytes.load();
+        Clock::time_point first = Clock::now();
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            Clock::time_point start = Clock::now();
+            operation(i);
+            Clock::time_point end = Clock::now();
+            samples[i] = std::max(
+                std::chrono::duration<double, std::nano>(end - start).count() - overhead, 0.0);
+        }
+
+        Clock::time_point last = Clock::now();
+
+        Result r;
+        r.allocations = allocationCount.load() - allocationsBefore;
+        r.allocatedBytes = allocationBytes.load() - bytesBefore;
+        r.workload = workload;
+        r.set = set;
+        r.parameter = parameter;
+        r.operations = count;
+        r.peakRssKb = peakRssKb();
+
+        if (count > 0)
+        {
+            double total = std::chrono::duration<double, std::nano>(last - first).count();
+            r.nsPerOperation = std::max(total / count - overhead, 0.0);
+
+            std::sort(samples.begin(), samples.end());
+            r.p50 = samples[count * 50 / 100];
+            r.p90 = samples[count * 90 / 100];
+            r.p99 = samples[count * 99 / 100];
+            r.max = samples.back();
+        }
+
+        return r;
+    }
+
+
+    // throughput() runs body(thread) on threadCount threads at once for
+    // about the given duration, where body returns the number of operations
+    // it did, and returns the average wall-clock time per operation.
+    template <typename Body>
+    Result throughput(
+        const std::string& workload, const std::string& set,
+        const std::string& parameter, unsigned int threadCount, Body&& body)
+    {
+        std::vector<std::thread> threads;
+        std::atomic<unsigned long long> operations{0};
+
+        unsigned long long allocationsBefore = allocationCount.load();
+        unsigned long long bytesBefore = allocationBytes.load();
+        Clock::time_point start = Clock::now();
+
+        for (unsigned int t = 0; t < threadCount; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                operations += body(t);
+            });
+        }
+
+        for (std::thread& thread: threads)
+        {
+            thread.join();
+        }
+
+        double total = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+        Result r;
+        r.allocations = allocationCount.load() - allocationsBefore;
+        r.allocatedBytes = allocationBytes.load() - bytesBefore;
+        r.workload = workload;
+        r.set = set;
+        r.parameter = parameter;
+        r.operations = operations.load();
+        r.nsPerOperation = r.operations == 0 ? 0.0 : total / r.operations;
+        r.peakRssKb = peakRssKb();
+        return r;
+    }
+
+
+    std::vector<unsigned int> threadCounts()
+    {
+        unsigned int hardware = std::max(std::thread::hardware_concurrency(), 1u);
+        std::vector<unsigned int> counts;
+
+        for (unsigned int count = 1; count < hardware; count *= 2)
+        {
+            counts.push_back(count);
+        }
+
+        counts.push_back(hardware);
+        return counts;
+    }
+
+
+    // The words every workload is run against: the dictionary, in sorted
+    // and shuffled order; words that aren't in it; and misspellings of
+    // words that are.
+    struct Corpus
+    {
+        std::vector<std::string> sorted;
+        std::vector<std::string> shuffled;
+        std::vector<std::string> misses;
+        std::vector<std::string> misspellings;
+    };
+
+
+    std::string randomWord(std::mt19937& random)
+    {
+        std::uniform_int_distribution<int> length{3, 12};
+        std::uniform_int_distribution<int> letter{'A', 'Z'};
+
+        std::string word(length(random), 'A');
+        for (char& c: word)
+        {
+            c = static_cast<char>(letter(random));
+        }
+        return word;
+    }
+
+
+    Corpus loadCorpus(const Options& options)
+    {
+        std::mt19937 random{46};
+        std::unordered_set<std::string> dictionary;
+
+        if (!options.wordsPath.empty())
+        {
+            std::ifstream in{options.wordsPath};
+            if (!in)
+            {
+                std::cerr << "cannot open " << options.wordsPath << std::endl;
+                std::exit(1);
+            }
+
+            std::string word;
+            while (std::getline(in, word))
+            {
+                if (!word.empty() && word.back() == '\r')
+                {
+                    word.pop_back();
+                }
+                if (!word.empty())
+                {
+                    dictionary.insert(word);
+                }
+            }
+        }
+        else
+        {
+            while (dictionary.size() < options.count)
+            {
+                dictionary.insert(randomWord(random));
+            }
+        }
+
+        Corpus corpus;
+        corpus.sorted.assign(dictionary.begin(), dictionary.end());
+        std::sort(corpus.sorted.begin(), corpus.sorted.end());
+        corpus.shuffled = corpus.sorted;
+        std::shuffle(corpus.shuffled.begin(), corpus.shuffled.end(), random);
+
+        while (corpus.misses.size() < corpus.sorted.size())
+        {
+            std::string word = randomWord(random);
+            if (dictionary.count(word) == 0)
+            {
+                corpus.misses.push_back(word);
+            }
+        }
+
+        std::uniform_int_distribution<int> letter{'A', 'Z'};
+        for (std::size_t i = 0; i < corpus.shuffled.size() && i < 2000; ++i)
+        {
+            std::string word = corpus.shuffled[i];
+            word[random() % word.size()] = static_cast<char>(letter(random));
+            corpus.misspellings.push_back(word);
+        }
+
+        return corpus;
+    }
+
+
+    // Each Set implementation is described by a name and a function that
+    // makes a new, empty one.
+    template <typename SetType>
+    struct Contender
+    {
+        std::string name;
+        std::function<std::unique_ptr<SetType>()> make;
+    };
+
+
+    template <typename SetType>
+    std::unique_ptr<SetType> build(const Contender<SetType>& contender, const std::vector<std::string>& words)
+    {
+        std::unique_ptr<SetType> set = contender.make();
+        for (const std::string& word: words)
+        {
+            set->add(word);
+        }
+        return set;
+    }
+
+
+    template <typename SetType>
+    void runCommonWorkloads(const Contender<SetType>& contender, const Corpus& corpus, Reporter& reporter)
+    {
+        const std::string& name = contender.name;
+
+        for (const char* order: {"sorted", "shuffled"})
+        {
+            std::string workload = std::string{"build-"} + order;
+            if (reporter.wants(workload))
+            {
+                const std::vector<std::string>& words =
+                    std::strcmp(order, "sorted") == 0 ? corpus.sorted : corpus.shuffled;
+                std::unique_ptr<SetType> set = contender.make();
+                reporter.report(measure(workload, name, "", words.size(),
+                    [&](std::size_t i) { set->add(words[i]); }));
+            }
+        }
+
+        std::unique_ptr<SetType> set = build(contender, corpus.shuffled);
+
+        for (unsigned int hitPercent: {100u, 50u, 10u})
+        {
+            std::string workload = "contains";
+            if (reporter.wants(workload))
+            {
+                std::size_t count = corpus.shuffled.size();
+                reporter.report(measure(workload, name, "hit=" + std::to_string(hitPercent) + "%", count,
+                    [&](std::size_t i)
+                    {
+                        const std::string& word =
+                            i % 100 < hitPercent ? corpus.shuffled[i] : corpus.misses[i];
+                        volatile bool found = set->contains(word);
+                        (void)found;
+                    }));
+            }
+        }
+
+        if (reporter.wants("suggestions"))
+        {
+            WordChecker checker{*set};
+            reporter.report(measure("suggestions", name, "", corpus.misspellings.size(),
+                [&](std::size_t i)
+                {
+                    volatile std::size_t found = checker.findSuggestions(corpus.misspellings[i]).size();
+                    (void)found;
+                }));
+        }
+
+        if constexpr (std::is_copy_constructible<SetType>::value)
+        {
+            if (reporter.wants("copy"))
+            {
+                reporter.report(measure("copy", name, "", 5,
+                    [&](std::size_t)
+                    {
+                        SetType copy{*set};
+                    }));
+            }
+
+            if (reporter.wants("move"))
+            {
+                reporter.report(measure("move", name, "", 5,
+                    [&](std::size_t)
+                    {
+                        SetType moved{std::move(*set)};
+                        *set = std::move(moved);
+                    }));
+            }
+        }
+
+        if (reporter.wants("destroy"))
+        {
+            reporter.report(measure("destroy", name, "", 1,
+                [&](std::size_t)
+                {
+                    set.reset();
+                }));
+        }
+    }
+
+
+    // How FlatHashSet's and HashSet's lookups change with their load
+    // factors.  Each FlatHashSet is filled to exactly the given proportion
+    // of a fixed capacity, with the maximum load factor set high enough
+    // that it doesn't resize first, and a HashSet with the same capacity is
+    // filled with the same elements.  A HashSet always grows once its load
+    // factor passes 0.8, so its last row reports the load factor it grew
+    // to rather than 0.9.
+    void runLoadFactorWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("flat-load-factor") && !reporter.wants("chain-load-factor"))
+        {
+            return;
+        }
+
+        unsigned int capacity = FlatHashSet<std::string>::DEFAULT_CAPACITY;
+        while (capacity * 0.9 < corpus.shuffled.size())
+        {
+            capacity *= 2;
+        }
+        capacity /= 2;
+
+        auto measureLookups = [&](const char* workload, const char* name, const auto& set, std::size_t count)
+        {
+            char parameter[32];
+            std::snprintf(parameter, sizeof(parameter), "load=%.2f",
+                static_cast<double>(set.size()) / set.getCapacity());
+
+            reporter.report(measure(std::string{workload} + "-hit", name, parameter, count,
+                [&](std::size_t i)
+                {
+                    volatile bool found = set.contains(corpus.shuffled[i]);
+                    (void)found;
+                }));
+            reporter.report(measure(std::string{workload} + "-miss", name, parameter, count,
+                [&](std::size_t i)
+                {
+                    volatile bool found = set.contains(corpus.misses[i]);
+                    (void)found;
+                }));
+        };
+
+        for (double loadFactor: {0.5, 0.6, 0.7, 0.8, 0.9})
+        {
+            std::size_t count = static_cast<std::size_t>(capacity * loadFactor);
+
+            if (reporter.wants("flat-load-factor"))
+            {
+                FlatHashSet<std::string> set{DefaultHasher<std::string>{}, std::equal_to<>{}, 0.95};
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    set.add(corpus.shuffled[i]);
+                }
+
+                measureLookups("flat-load-factor", "FlatHashSet", set, count);
+            }
+
+            if (reporter.wants("chain-load-factor"))
+            {
+                // reserve() sizes the array for count / 0.8 elements, so
+                // this gives the HashSet the same capacity.
+                HashSet<std::string> set;
+                set.reserve(static_cast<unsigned int>(capacity * 0.8));
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    set.add(corpus.shuffled[i]);
+                }
+
+                measureLookups("chain-load-factor", "HashSet", set, count);
+            }
+        }
+    }
+
+
+    void runBulkBuildWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("avl-bulk-build"))
+        {
+            return;
+        }
+
+        reporter.report(measure("avl-bulk-build", "AVLSet", "sorted", 1,
+            [&](std::size_t)
+            {
+                AVLSet<std::string> set{corpus.sorted.begin(), corpus.sorted.end()};
+            }));
+        reporter.report(measure("avl-bulk-build", "AVLSet", "shuffled", 1,
+            [&](std::size_t)
+            {
+                AVLSet<std::string> set{corpus.shuffled.begin(), corpus.shuffled.end()};
+            }));
+    }
+
+
+    // Full in-order scans of an AVLSet, through a VisitFunction, through a
+    // lambda that can be inlined, and with iterators.
+    void runTraversalWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("inorder-scan"))
+        {
+            return;
+        }
+
+        AVLSet<std::string> set{corpus.sorted.begin(), corpus.sorted.end()};
+        std::size_t totalLength = 0;
+
+        reporter.report(measure("inorder-scan", "AVLSet", "VisitFunction", 5,
+            [&](std::size_t)
+            {
+                set.inorder([&](const std::string& word) { totalLength += word.size(); });
+            }));
+        reporter.report(measure("inorder-scan", "AVLSet", "forEachInorder", 5,
+            [&](std::size_t)
+            {
+                set.forEachInorder([&](const std::string& word) { totalLength += word.size(); });
+            }));
+        reporter.report(measure("inorder-scan", "AVLSet", "iterators", 5,
+            [&](std::size_t)
+            {
+                for (const std::string& word: set)
+                {
+                    totalLength += word.size();
+                }
+            }));
+
+        BPlusTreeSet<std::string> tree;
+        for (const std::string& word: corpus.sorted)
+        {
+            tree.add(word);
+        }
+
+        reporter.report(measure("inorder-scan", "BPlusTreeSet", "forEachInorder", 5,
+            [&](std::size_t)
+            {
+                tree.forEachInorder([&](const std::string& word) { totalLength += word.size(); });
+            }));
+
+        volatile std::size_t sink = totalLength;
+        (void)sink;
+    }
+
+
+    // The space an ordered set takes per element, and how quickly it can
+    // find its elements, for an AVLSet and for BPlusTreeSets with nodes
+    // the size of a few cache lines up to a page.  The space is what was
+    // allocated while building the set (the words are short enough not to
+    // allocate space of their own), divided by the number of words.
+    template <typename SetType>
+    void runTreeWorkload(const std::string& name, const Corpus& corpus, Reporter& reporter)
+    {
+        std::unique_ptr<SetType> set;
+
+        Result build = measure("memory-per-element", name, "", 1,
+            [&](std::size_t)
+            {
+                set = std::make_unique<SetType>();
+                for (const std::string& word: corpus.shuffled)
+                {
+                    set->add(word);
+                }
+            });
+
+        char parameter[32];
+        std::snprintf(parameter, sizeof(parameter), "bytes/word=%.1f",
+            static_cast<double>(build.allocatedBytes) / corpus.shuffled.size());
+        build.parameter = parameter;
+        reporter.report(build);
+
+        reporter.report(measure("tree-contains", name, "hit", corpus.shuffled.size(),
+            [&](std::size_t i)
+            {
+                volatile bool found = set->contains(corpus.shuffled[i]);
+                (void)found;
+            }));
+        reporter.report(measure("tree-contains", name, "miss", corpus.misses.size(),
+            [&](std::size_t i)
+            {
+                volatile bool found = set->contains(corpus.misses[i]);
+                (void)found;
+            }));
+    }
+
+
+    void runTreeWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("memory-per-element") && !reporter.wants("tree-contains"))
+        {
+            return;
+        }
+
+        runTreeWorkload<AVLSet<std::string>>("AVLSet", corpus, reporter);
+        runTreeWorkload<BPlusTreeSet<std::string, 256>>("BPlusTreeSet(256)", corpus, reporter);
+        runTreeWorkload<BPlusTreeSet<std::string, 512>>("BPlusTreeSet(512)", corpus, reporter);
+        runTreeWorkload<BPlusTreeSet<std::string, 4096>>("BPlusTreeSet(4096)", corpus, reporter);
+    }
+
+
+    // The space a set of words takes per word, and how quickly it finds
+    // them, with each word stored as a std::string and with the words
+    // interned in a StringArena.  It's measured for the dictionary as it
+    // is and with every word made long enough that a std::string has to
+    // allocate space for its characters, as most words in languages with
+    // long compound words would.
+    template <typename SetType>
+    void runInternedWorkload(
+        const std::string& name, const std::string& words,
+        const std::vector<std::string>& dictionary, Reporter& reporter)
+    {
+        std::unique_ptr<SetType> set;
+
+        Result build = measure("memory-per-word", name, "", 1,
+            [&](std::size_t)
+            {
+                set = std::make_unique<SetType>();
+                for (const std::string& word: dictionary)
+                {
+                    set->add(word);
+                }
+            });
+
+        char parameter[48];
+        std::snprintf(parameter, sizeof(parameter), "%s bytes/word=%.1f",
+            words.c_str(), static_cast<double>(build.allocatedBytes) / dictionary.size());
+        build.parameter = parameter;
+        reporter.report(build);
+
+        reporter.report(measure("interned-contains", name, words, dictionary.size(),
+            [&](std::size_t i)
+            {
+                volatile bool found = set->contains(dictionary[i]);
+                (void)found;
+            }));
+    }
+
+
+    void runInternedWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("memory-per-word") && !reporter.wants("interned-contains"))
+        {
+            return;
+        }
+
+        std::vector<std::string> longWords;
+        for (const std::string& word: corpus.shuffled)
+        {
+            longWords.push_back(word + "GESELLSCHAFT");
+        }
+
+        auto run = [&](const std::string& words, const std::vector<std::string>& dictionary)
+        {
+            runInternedWorkload<HashSet<std::string>>("HashSet", words, dictionary, reporter);
+            runInternedWorkload<InternedHashSet>("InternedHashSet", words, dictionary, reporter);
+            runInternedWorkload<AVLSet<std::string>>("AVLSet", words, dictionary, reporter);
+            runInternedWorkload<InternedAVLSet>("InternedAVLSet", words, dictionary, reporter);
+        };
+
+        run("short", corpus.shuffled);
+        run("long", longWords);
+    }
+
+
+    // Checks the strings at the edges of what a StringArena holds rather
+    // than timing anything: empty strings, including one appended just as
+    // a chunk has been filled, and strings exactly as long as a chunk.
+    // Any failure stops the benchmark.
+    void runInternedEdgeChecks(Reporter& reporter)
+    {
+        if (!reporter.wants("interned-edges"))
+        {
+            return;
+        }
+
+        auto fail = [](const std::string& problem)
+        {
+            std::cerr << "interned-edges: " << problem << std::endl;
+            std::exit(1);
+        };
+
+        std::string full(StringArena::CHUNK_SIZE, 'A');
+
+        StringArena arena;
+        StringHandle first = arena.append("");
+        StringHandle filled = arena.append(full);
+        StringHandle afterFull = arena.append("");
+        StringHandle next = arena.append("WORD");
+
+        if (!arena.view(first).empty() || !arena.view(afterFull).empty())
+        {
+            fail("an empty string wasn't empty when viewed");
+        }
+
+        if (arena.view(filled) != full || arena.view(next) != "WORD")
+        {
+            fail("a string next to an empty one was changed");
+        }
+
+        if (afterFull.offset / StringArena::CHUNK_SIZE >= arena.bytesAllocated() / StringArena::CHUNK_SIZE)
+        {
+            fail("an empty string appended to a full chunk is outside every chunk");
+        }
+
+        auto check = [&](auto& set, const std::string& name)
+        {
+            set.add(full);
+            set.add("");
+            set.add("");
+
+            if (!set.contains("") || !set.contains(full) || set.contains("A") || set.size() != 2)
+            {
+                fail(name + " lost an empty string or one as long as a chunk");
+            }
+        };
+
+        InternedHashSet hashSet;
+        check(hashSet, "InternedHashSet");
+
+        InternedAVLSet avlSet;
+        check(avlSet, "InternedAVLSet");
+    }
+
+
+    // Lookups in a FrozenSet made by freezing a HashSet, against the
+    // HashSet itself and a FlatHashSet.  The freeze is reported with the
+    // space the finished FrozenSet takes per word.  The words are looked
+    // up in sorted order, unlike the order they were added in, since the
+    // HashSet's nodes are laid out in the order they were added, and
+    // looking them up in that order would walk through memory in order.
+    void runFrozenWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("frozen"))
+        {
+            return;
+        }
+
+        HashSet<std::string> hashSet;
+        FlatHashSet<std::string> flatSet;
+        for (const std::string& word: corpus.shuffled)
+        {
+            hashSet.add(word);
+            flatSet.add(word);
+        }
+
+        std::unique_ptr<FrozenSet<std::string>> frozenSet;
+        Result build = measure("frozen-build", "FrozenSet", "", 1,
+            [&](std::size_t)
+            {
+                frozenSet = std::make_unique<FrozenSet<std::string>>(freeze(hashSet));
+            });
+
+        double frozenBytes = sizeof(std::string) * frozenSet->size()
+            + sizeof(std::uint32_t) * frozenSet->bucketCount();
+
+        char parameter[32];
+        std::snprintf(parameter, sizeof(parameter), "bytes/word=%.1f", frozenBytes / corpus.shuffled.size());
+        build.parameter = parameter;
+        reporter.report(build);
+
+        auto lookups = [&](const std::string& name, const Set<std::string>& set)
+        {
+            for (unsigned int hitPercent: {100u, 50u, 0u})
+            {
+                reporter.report(measure("frozen-contains", name, "hit=" + std::to_string(hitPercent) + "%",
+                    corpus.shuffled.size(),
+                    [&](std::size_t i)
+                    {
+                        const std::string& word =
+                            i % 100 < hitPercent ? corpus.sorted[i] : corpus.misses[i];
+                        volatile bool found = set.contains(word);
+                        (void)found;
+                    }));
+            }
+        };
+
+        lookups("HashSet", hashSet);
+        lookups("FlatHashSet", flatSet);
+        lookups("FrozenSet", *frozenSet);
+    }
+
+
+    // Every word within one and two edits of each misspelling, found by a
+    // single search of a TrieSet and by expanding the candidates of the
+    // five techniques and looking each one up in a HashSet.  Searching
+    // within two edits by expanding the candidates makes hundreds of
+    // thousands of lookups per word, so it's run on fewer words.
+    void runEditDistanceWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("edit-distance"))
+        {
+            return;
+        }
+
+        HashSet<std::string> hashSet;
+        std::unique_ptr<TrieSet> trie;
+
+        Result build = measure("edit-distance-build", "TrieSet", "", 1,
+            [&](std::size_t)
+            {
+                trie = std::make_unique<TrieSet>();
+                for (const std::string& word: corpus.shuffled)
+                {
+                    trie->add(word);
+                }
+            });
+
+        char parameter[48];
+        std::snprintf(parameter, sizeof(parameter), "nodes/word=%.2f bytes/word=%.1f",
+            static_cast<double>(trie->nodeCount()) / trie->size(),
+            static_cast<double>(build.allocatedBytes) / trie->size());
+        build.parameter = parameter;
+        reporter.report(build);
+
+        for (const std::string& word: corpus.shuffled)
+        {
+            hashSet.add(word);
+        }
+
+        WordChecker generator{hashSet};
+        WordChecker search{*trie};
+
+        for (unsigned int distance: {1u, 2u})
+        {
+            std::size_t count = std::min<std::size_t>(corpus.misspellings.size(), distance == 1 ? 2000 : 50);
+            std::string k = "k=" + std::to_string(distance);
+
+            reporter.report(measure("edit-distance", "HashSet(generator)", k, count,
+                [&](std::size_t i)
+                {
+                    volatile std::size_t found = generator.findSuggestionsWithin(corpus.misspellings[i], distance).size();
+                    (void)found;
+                }));
+            reporter.report(measure("edit-distance", "TrieSet", k, count,
+                [&](std::size_t i)
+                {
+                    volatile std::size_t found = search.findSuggestionsWithin(corpus.misspellings[i], distance).size();
+                    (void)found;
+                }));
+        }
+    }
+
+
+    // How the size of a SuggestionIndex and the time to look a word up in
+    // it grow with the distance it's built for, against expanding the
+    // candidates of the five techniques and looking each one up in an
+    // AVLSet.  An index within three edits of a few hundred thousand words
+    // takes gigabytes to build, so these use at most 50,000 of them.
+    void runSuggestionIndexWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("suggestion-index"))
+        {
+            return;
+        }
+
+        std::vector<std::string> words{
+            corpus.shuffled.begin(),
+            corpus.shuffled.begin() + std::min<std::size_t>(corpus.shuffled.size(), 50000)};
+
+        AVLSet<std::string> avlSet;
+        for (const std::string& word: words)
+        {
+            avlSet.add(word);
+        }
+
+        WordChecker generator{avlSet};
+        auto queryCount = [&](unsigned int distance)
+        {
+            return std::min<std::size_t>(corpus.misspellings.size(), distance == 1 ? 2000 : 50);
+        };
+
+        for (unsigned int distance: {1u, 2u})
+        {
+            reporter.report(measure("suggestion-index", "AVLSet(generator)", "k=" + std::to_string(distance),
+                queryCount(distance),
+                [&](std::size_t i)
+                {
+                    volatile std::size_t found = generator.findSuggestionsWithin(corpus.misspellings[i], distance).size();
+                    (void)found;
+                }));
+        }
+
+        for (unsigned int built: {1u, 2u, 3u})
+        {
+            std::unique_ptr<SuggestionIndex> index;
+
+            Result build = measure("suggestion-index-build", "SuggestionIndex", "", 1,
+                [&](std::size_t)
+                {
+                    index = std::make_unique<SuggestionIndex>(words, built);
+                });
+
+            char parameter[64];
+            std::snprintf(parameter, sizeof(parameter), "k=%u keys/word=%.1f bytes/word=%.1f",
+                built,
+                static_cast<double>(index->keyCount()) / index->size(),
+                static_cast<double>(index->bytesUsed()) / index->size());
+            build.parameter = parameter;
+            reporter.report(build);
+
+            WordChecker checker{avlSet};
+            checker.setSuggestionIndex(index.get());
+
+            for (unsigned int distance = 1; distance <= built; ++distance)
+            {
+                std::snprintf(parameter, sizeof(parameter), "built=%u k=%u", built, distance);
+                reporter.report(measure("suggestion-index", "SuggestionIndex", parameter, queryCount(1),
+                    [&](std::size_t i)
+                    {
+                        volatile std::size_t found = checker.findSuggestionsWithin(corpus.misspellings[i], distance).size();
+                        (void)found;
+                    }));
+            }
+        }
+    }
+
+
+    // Loading a word list whose size is known in advance, one line at a
+    // time, into each kind of set: by making each line into a string and
+    // adding that, which copies it again, by adding the string as an rvalue so that it's moved
+    // into the node, and by emplacing each word straight from the text,
+    // into a HashSet that starts at its default capacity or has been
+    // reserved first.  Words of up to 15 characters fit inside a
+    // std::string, so the long words show what's saved when a string has
+    // to allocate its characters.
+    template <typename SetType>
+    void runDictionaryLoadWorkload(
+        const std::string& name, const std::string& words, const std::string& text,
+        std::size_t count, Reporter& reporter)
+    {
+        auto forEachLine = [&](auto&& visit)
+        {
+            for (std::size_t start = 0, end; start < text.size(); start = end + 1)
+            {
+                end = text.find('\n', start);
+                visit(std::string_view{text}.substr(start, end - start));
+            }
+        };
+
+        auto run = [&](const std::string& method, auto&& load)
+        {
+            Result r = measure("dictionary-load", name, "", 1,
+                [&](std::size_t)
+                {
+                    SetType set;
+                    load(set);
+                });
+
+            char parameter[64];
+            std::snprintf(parameter, sizeof(parameter), "%s %s allocs/word=%.2f",
+                words.c_str(), method.c_str(), static_cast<double>(r.allocations) / count);
+            r.parameter = parameter;
+            reporter.report(r);
+        };
+
+        run("add(copy)", [&](SetType& set)
+            {
+                forEachLine([&](std::string_view line) { std::string word{line}; set.add(word); });
+            });
+        run("add(move)", [&](SetType& set)
+            {
+                forEachLine([&](std::string_view line) { set.add(std::string{line}); });
+            });
+        run("emplace", [&](SetType& set)
+            {
+                forEachLine([&](std::string_view line) { set.emplace(line); });
+            });
+
+        if constexpr (std::is_same<SetType, HashSet<std::string>>::value)
+        {
+            run("reserve+emplace", [&](SetType& set)
+                {
+                    set.reserve(static_cast<unsigned int>(count));
+                    forEachLine([&](std::string_view line) { set.emplace(line); });
+                });
+        }
+    }
+
+
+    void runDictionaryLoadWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("dictionary-load"))
+        {
+            return;
+        }
+
+        std::string shortText;
+        std::string longText;
+        for (const std::string& word: corpus.shuffled)
+        {
+            shortText += word + '\n';
+            longText += word + "GESELLSCHAFT\n";
+        }
+
+        for (const auto& [words, text]: {std::make_pair("short", &shortText), std::make_pair("long", &longText)})
+        {
+            runDictionaryLoadWorkload<HashSet<std::string>>("HashSet", words, *text, corpus.shuffled.size(), reporter);
+            runDictionaryLoadWorkload<AVLSet<std::string>>("AVLSet", words, *text, corpus.shuffled.size(), reporter);
+        }
+    }
+
+
+    // Retracting 1% of the words from a full dictionary, by removing them
+    // one at a time and, for comparison, by rebuilding the set without them.
+    template <typename SetType>
+    void runRemoveWorkload(const std::string& name, const Corpus& corpus, Reporter& reporter)
+    {
+        std::size_t count = corpus.shuffled.size() / 100;
+
+        {
+            SetType set;
+            for (const std::string& word: corpus.shuffled)
+            {
+                set.add(word);
+            }
+
+            reporter.report(measure("remove", name, "1%", count,
+                [&](std::size_t i)
+                {
+                    set.remove(corpus.shuffled[i]);
+                }));
+        }
+
+        reporter.report(measure("remove-by-rebuild", name, "1%", 1,
+            [&](std::size_t)
+            {
+                SetType set;
+                for (std::size_t i = count; i < corpus.shuffled.size(); ++i)
+                {
+                    set.add(corpus.shuffled[i]);
+                }
+            }));
+    }
+
+
+    void runRemoveWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("remove"))
+        {
+            return;
+        }
+
+        runRemoveWorkload<AVLSet<std::string>>("AVLSet", corpus, reporter);
+        runRemoveWorkload<HashSet<std::string>>("HashSet", corpus, reporter);
+    }
+
+
+    // The time from starting up to answering the first lookup: reading a
+    // word list and adding every word to a set, against opening a snapshot
+    // of the same words.  Both files will be in the page cache, so this
+    // measures the work done by the process rather than the disk.
+    void runStartupWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("first-lookup"))
+        {
+            return;
+        }
+
+        std::filesystem::path directory = std::filesystem::temp_directory_path();
+        std::string wordsPath = (directory / "benchmark-words.txt").string();
+        std::string snapshotPath = (directory / "benchmark-words.snapshot").string();
+
+        {
+            std::ofstream out{wordsPath};
+            for (const std::string& word: corpus.shuffled)
+            {
+                out << word << '\n';
+            }
+        }
+
+        MappedWordSet::write(snapshotPath, corpus.shuffled.begin(), corpus.shuffled.end());
+        const std::string& probe = corpus.shuffled.back();
+
+        auto rebuild = [&](Set<std::string>& set)
+        {
+            std::ifstream in{wordsPath};
+            std::string word;
+            while (std::getline(in, word))
+            {
+                set.add(word);
+            }
+
+            volatile bool found = set.contains(probe);
+            (void)found;
+        };
+
+        reporter.report(measure("first-lookup", "AVLSet", "word list", 3,
+            [&](std::size_t)
+            {
+                AVLSet<std::string> set;
+                rebuild(set);
+            }));
+        reporter.report(measure("first-lookup", "HashSet", "word list", 3,
+            [&](std::size_t)
+            {
+                HashSet<std::string> set;
+                rebuild(set);
+            }));
+        reporter.report(measure("first-lookup", "MappedWordSet", "snapshot", 3,
+            [&](std::size_t)
+            {
+                MappedWordSet set{snapshotPath};
+                volatile bool found = set.contains(probe);
+                (void)found;
+            }));
+
+        std::filesystem::remove(wordsPath);
+        std::filesystem::remove(snapshotPath);
+    }
+
+
+    // findSuggestions() with a BloomFilter in front of the set, built for a
+    // few false positive rates.  The parameter shows the rate the filter
+    // was built for, the proportion of lookups it rejected, and the
+    // proportion of the words not in the set that it let through.
+    template <typename SetType>
+    void runFilterWorkload(const std::string& name, const Corpus& corpus, Reporter& reporter)
+    {
+        SetType set;
+        for (const std::string& word: corpus.shuffled)
+        {
+            set.add(word);
+        }
+
+        for (double rate: {0.05, 0.01, 0.001})
+        {
+            BloomFilter filter{corpus.shuffled.begin(), corpus.shuffled.end(), rate};
+            WordChecker checker{set};
+            checker.setFilter(&filter);
+
+            Result r = measure("filtered-suggestions", name, "", corpus.misspellings.size(),
+                [&](std::size_t i)
+                {
+                    volatile std::size_t found = checker.findSuggestions(corpus.misspellings[i]).size();
+                    (void)found;
+                });
+
+            WordChecker::FilterStats stats = checker.filterStats();
+            unsigned long long misses = stats.rejected + stats.falsePositives;
+            char parameter[48];
+            std::snprintf(parameter, sizeof(parameter), "p=%g rej=%.1f%% fp=%.2f%%",
+                rate, 100.0 * stats.rejected / std::max(stats.lookups, 1ull),
+                100.0 * stats.falsePositives / std::max(misses, 1ull));
+            r.parameter = parameter;
+            reporter.report(r);
+        }
+    }
+
+
+    void runFilterWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("filtered-suggestions"))
+        {
+            return;
+        }
+
+        runFilterWorkload<AVLSet<std::string>>("AVLSet", corpus, reporter);
+        runFilterWorkload<HashSet<std::string>>("HashSet", corpus, reporter);
+    }
+
+
+    // findSuggestions() on misspellings of long words, with the default
+    // hasher, where every candidate is hashed from scratch, and with a
+    // PolynomialHasher, where each candidate's hash is found from the edit
+    // that made it.  Each is also measured with a BloomFilter attached,
+    // which hashes words the same way as the set, so that with a
+    // PolynomialHasher it's given each candidate's hash rather than
+    // hashing the candidate again.
+    void runRollingHashWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("rolling-suggestions"))
+        {
+            return;
+        }
+
+        for (std::size_t length: {8, 32, 128})
+        {
+            std::mt19937 random{static_cast<unsigned int>(length)};
+            std::uniform_int_distribution<int> letter{'A', 'Z'};
+            std::vector<std::string> words;
+            std::vector<std::string> misspellings;
+
+            for (std::size_t i = 0; i < 2000; ++i)
+            {
+                std::string word(length, 'A');
+                for (char& c: word)
+                {
+                    c = static_cast<char>(letter(random));
+                }
+                words.push_back(word);
+
+                word[random() % length] = static_cast<char>(letter(random));
+                misspellings.push_back(word);
+            }
+
+            HashSet<std::string> standard;
+            HashSet<std::string, PolynomialHasher> polynomial;
+            for (const std::string& word: corpus.shuffled)
+            {
+                standard.add(word);
+                polynomial.add(word);
+            }
+            for (const std::string& word: words)
+            {
+                standard.add(word);
+                polynomial.add(word);
+            }
+
+            std::size_t filterSize = words.size() + corpus.shuffled.size();
+            BloomFilter standardFilter{filterSize};
+            BloomFilter polynomialFilter{
+                filterSize, BloomFilter::DEFAULT_FALSE_POSITIVE_RATE, BloomFilter::Hashing::Polynomial};
+            for (const std::string& word: corpus.shuffled)
+            {
+                standardFilter.add(word);
+                polynomialFilter.add(word);
+            }
+            for (const std::string& word: words)
+            {
+                standardFilter.add(word);
+                polynomialFilter.add(word);
+            }
+
+            std::string parameter = "length=" + std::to_string(length);
+            WordChecker standardChecker{standard};
+            WordChecker polynomialChecker{polynomial};
+            WordChecker filteredStandardChecker{standard};
+            WordChecker filteredPolynomialChecker{polynomial};
+            filteredStandardChecker.setFilter(&standardFilter);
+            filteredPolynomialChecker.setFilter(&polynomialFilter);
+
+            auto run = [&](const std::string& name, const WordChecker& checker)
+            {
+                reporter.report(measure("rolling-suggestions", name, parameter, misspellings.size(),
+                    [&](std::size_t i)
+                    {
+                        volatile std::size_t found = checker.findSuggestions(misspellings[i]).size();
+                        (void)found;
+                    }));
+            };
+
+            run("HashSet", standardChecker);
+            run("HashSet(polynomial)", polynomialChecker);
+            run("HashSet(filtered)", filteredStandardChecker);
+            run("HashSet(poly,filtered)", filteredPolynomialChecker);
+        }
+    }
+
+
+    // Finding the words with a given prefix, with WordChecker's
+    // autocomplete() (a prefix scan of the AVLSet) and, for comparison, by
+    // checking every word in a full in-order scan.
+    void runAutocompleteWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("autocomplete"))
+        {
+            return;
+        }
+
+        AVLSet<std::string> set{corpus.sorted.begin(), corpus.sorted.end()};
+        WordChecker checker{set};
+        std::size_t found = 0;
+
+        for (std::size_t length: {1, 2, 3})
+        {
+            std::vector<std::string> prefixes;
+            for (std::size_t i = 0; i < 1000; ++i)
+            {
+                prefixes.push_back(corpus.shuffled[i % corpus.shuffled.size()].substr(0, length));
+            }
+
+            std::string parameter = "prefix=" + std::to_string(length);
+
+            reporter.report(measure("autocomplete", "AVLSet", parameter, prefixes.size(),
+                [&](std::size_t i)
+                {
+                    found += checker.autocomplete(prefixes[i], 10).size();
+                }));
+            reporter.report(measure("autocomplete-full-scan", "AVLSet", parameter, 20,
+                [&](std::size_t i)
+                {
+                    const std::string& prefix = prefixes[i];
+                    set.forEachInorder(
+                        [&](const std::string& word)
+                        {
+                            found += word.compare(0, prefix.size(), prefix) == 0;
+                        });
+                }));
+        }
+
+        volatile std::size_t sink = found;
+        (void)sink;
+    }
+
+
+    void runBatchWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("batch-check"))
+        {
+            return;
+        }
+
+        HashSet<std::string> set;
+        for (const std::string& word: corpus.shuffled)
+        {
+            set.add(word);
+        }
+
+        WordChecker checker{set};
+        std::vector<std::string> batch;
+        for (std::size_t i = 0; i < 20000; ++i)
+        {
+            batch.push_back(corpus.misspellings[i % corpus.misspellings.size()]);
+        }
+
+        for (unsigned int threads: threadCounts())
+        {
+            reporter.report(measure("batch-check", "HashSet", "threads=" + std::to_string(threads), 1,
+                [&](std::size_t)
+                {
+                    volatile std::size_t checked = checker.checkWords(batch, threads).size();
+                    (void)checked;
+                }));
+        }
+    }
+
+
+    // Suggestions for skewed traffic, in which a few misspellings make up
+    // most of the queries: the rth most common of them is asked about in
+    // proportion to 1/r.  Each LRU cache size is reported with the share
+    // of the queries it answered, first from one thread and then from a
+    // checkWords() batch spread over every hardware thread.
+    void runSuggestionCacheWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("cached-suggestions"))
+        {
+            return;
+        }
+
+        std::vector<double> weights;
+        for (std::size_t rank = 1; rank <= corpus.misspellings.size(); ++rank)
+        {
+            weights.push_back(1.0 / rank);
+        }
+
+        std::mt19937 random{46};
+        std::discrete_distribution<std::size_t> popularity{weights.begin(), weights.end()};
+        std::vector<std::string> queries;
+        for (std::size_t i = 0; i < 50000; ++i)
+        {
+            queries.push_back(corpus.misspellings[popularity(random)]);
+        }
+
+        AVLSet<std::string> set;
+        for (const std::string& word: corpus.shuffled)
+        {
+            set.add(word);
+        }
+
+        unsigned int threads = threadCounts().back();
+
+        for (std::size_t capacity: {std::size_t{0}, std::size_t{100}, std::size_t{1000}})
+        {
+            WordChecker checker{set};
+            std::unique_ptr<SuggestionCache> cache;
+
+            if (capacity > 0)
+            {
+                cache = std::make_unique<SuggestionCache>(capacity);
+                checker.setSuggestionCache(cache.get());
+            }
+
+            auto describe = [&](Result& result)
+            {
+                if (cache)
+                {
+                    SuggestionCache::Stats stats = cache->stats();
+                    char parameter[48];
+                    std::snprintf(parameter, sizeof(parameter), "capacity=%zu hit-rate=%.1f%%",
+                        capacity, 100.0 * stats.hits / std::max<unsigned long long>(stats.hits + stats.misses, 1));
+                    result.parameter += parameter;
+                    cache->clear();
+                    cache->resetStats();
+                }
+                else
+                {
+                    result.parameter += "no cache";
+                }
+
+                reporter.report(result);
+            };
+
+            Result single = measure("cached-suggestions", "AVLSet", "", queries.size(),
+                [&](std::size_t i)
+                {
+                    volatile std::size_t found = checker.findSuggestions(queries[i]).size();
+                    (void)found;
+                });
+            describe(single);
+
+            Result batch = measure("cached-suggestions", "AVLSet",
+                "threads=" + std::to_string(threads) + " ", 1,
+                [&](std::size_t)
+                {
+                    volatile std::size_t checked = checker.checkWords(queries, threads).size();
+                    (void)checked;
+                });
+            describe(batch);
+        }
+    }
+
+
+    // Spell-checking a 64 MB text file (of dictionary words in lowercase,
+    // one in 32 of them misspelled, with punctuation and line breaks
+    // between them), by reading it a line at a time and checking each word
+    // with wordExists(), and by streaming it through a SpellCheckStream.
+    void runStreamWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("stream-check"))
+        {
+            return;
+        }
+
+        std::filesystem::path directory = std::filesystem::temp_directory_path();
+        std::string textPath = (directory / "benchmark-text.txt").string();
+        std::uint64_t textSize = 0;
+
+        {
+            std::mt19937 random{46};
+            std::ofstream out{textPath, std::ios::binary};
+            const char* separators[] = {" ", " ", " ", " ", ", ", ". ", "\n"};
+            std::string word;
+
+            for (std::size_t i = 0; textSize < (std::uint64_t{64} << 20); ++i)
+            {
+                word = i % 32 == 31
+                    ? corpus.misspellings[random() % corpus.misspellings.size()]
+                    : corpus.shuffled[random() % corpus.shuffled.size()];
+
+                for (char& c: word)
+                {
+                    c = static_cast<char>(c - 'A' + 'a');
+                }
+
+                const char* separator = separators[random() % 7];
+                out << word << separator;
+                textSize += word.size() + std::strlen(separator);
+            }
+        }
+
+        HashSet<std::string> set;
+        for (const std::string& word: corpus.shuffled)
+        {
+            set.add(word);
+        }
+
+        WordChecker checker{set};
+
+        auto describe = [&](Result result)
+        {
+            char parameter[32];
+            std::snprintf(parameter, sizeof(parameter), "MB/s=%.1f",
+                textSize / (result.nsPerOperation / 1e9) / (1 << 20));
+            result.parameter += parameter;
+            reporter.report(result);
+        };
+
+        describe(measure("stream-check", "getline+wordExists", "", 1,
+            [&](std::size_t)
+            {
+                std::ifstream in{textPath, std::ios::binary};
+                std::string line;
+                std::string word;
+                std::size_t misspelled = 0;
+
+                while (std::getline(in, line))
+                {
+                    for (std::size_t i = 0; i <= line.size(); ++i)
+                    {
+                        char c = i < line.size() ? line[i] : ' ';
+
+                        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+                        {
+                            word.push_back(static_cast<char>(c >= 'a' ? c - 'a' + 'A' : c));
+                        }
+                        else if (!word.empty())
+                        {
+                            misspelled += checker.wordExists(word) ? 0 : 1;
+                            word.clear();
+                        }
+                    }
+                }
+
+                volatile std::size_t sink = misspelled;
+                (void)sink;
+            }));
+
+        for (unsigned int threads: threadCounts())
+        {
+            describe(measure("stream-check", "SpellCheckStream", "threads=" + std::to_string(threads) + " ", 1,
+                [&](std::size_t)
+                {
+                    SpellCheckStream::Options options = SpellCheckStream::defaultOptions();
+                    options.threadCount = threads;
+
+                    SpellCheckStream stream{checker, textPath, options};
+                    std::size_t misspelled = 0;
+                    stream.run([&](const SpellCheckStream::Misspelling&) { ++misspelled; });
+
+                    volatile std::size_t sink = misspelled;
+                    (void)sink;
+                }));
+        }
+
+        std::filesystem::remove(textPath);
+    }
+
+
+    // Readers looking up words while one writer adds new ones, comparing
+    // ConcurrentHashSet against a HashSet guarded by a single mutex.
+    void runConcurrentWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("concurrent"))
+        {
+            return;
+        }
+
+        const std::chrono::milliseconds duration{300};
+        std::size_t half = corpus.shuffled.size() / 2;
+
+        for (unsigned int readers: threadCounts())
+        {
+            std::string parameter = "readers=" + std::to_string(readers);
+
+            {
+                ConcurrentHashSet<std::string> set;
+                for (std::size_t i = 0; i < half; ++i)
+                {
+                    set.add(corpus.shuffled[i]);
+                }
+
+                std::atomic<bool> stop{false};
+                Clock::time_point end = Clock::now() + duration;
+
+                reporter.report(throughput("concurrent-read", "ConcurrentHashSet", parameter, readers + 1,
+                    [&](unsigned int thread) -> unsigned long long
+                    {
+                        unsigned long long operations = 0;
+                        if (thread == 0)
+                        {
+                            for (std::size_t i = half; i < corpus.shuffled.size() && Clock::now() < end; ++i)
+                            {
+                                set.add(corpus.shuffled[i]);
+                                ++operations;
+                            }
+                            stop = true;
+                        }
+                        else
+                        {
+                            for (std::size_t i = thread; !stop && Clock::now() < end; i += 7)
+                            {
+                                volatile bool found = set.contains(corpus.shuffled[i % half]);
+                                (void)found;
+                                ++operations;
+                            }
+                        }
+                        return operations;
+                    }));
+            }
+
+            {
+                HashSet<std::string> set;
+                std::mutex mutex;
+                for (std::size_t i = 0; i < half; ++i)
+                {
+                    set.add(corpus.shuffled[i]);
+                }
+
+                std::atomic<bool> stop{false};
+                Clock::time_point end = Clock::now() + duration;
+
+                reporter.report(throughput("concurrent-read", "HashSet+mutex", parameter, readers + 1,
+                    [&](unsigned int thread) -> unsigned long long
+                    {
+                        unsigned long long operations = 0;
+                        if (thread == 0)
+                        {
+                            for (std::size_t i = half; i < corpus.shuffled.size() && Clock::now() < end; ++i)
+                            {
+                                std::lock_guard<std::mutex> lock{mutex};
+                                set.add(corpus.shuffled[i]);
+                                ++operations;
+                            }
+                            stop = true;
+                        }
+                        else
+                        {
+                            for (std::size_t i = thread; !stop && Clock::now() < end; i += 7)
+                            {
+                                std::lock_guard<std::mutex> lock{mutex};
+                                volatile bool found = set.contains(corpus.shuffled[i % half]);
+                                (void)found;
+                                ++operations;
+                            }
+                        }
+                        return operations;
+                    }));
+            }
+        }
+    }
+
+
+    // Checks ConcurrentHashSet under contention rather than timing it: every
+    // thread adds its share of the corpus while looking up what it has
+    // already added and words that are never added, and once they've all
+    // finished, every word must be found exactly once and no miss found.
+    // Any failure stops the benchmark.
+    void runConcurrentStressWorkloads(const Corpus& corpus, Reporter& reporter)
+    {
+        if (!reporter.wants("concurrent-stress"))
+        {
+            return;
+        }
+
+        auto fail = [](const std::string& problem)
+        {
+            std::cerr << "concurrent-stress: " << problem << std::endl;
+            std::exit(1);
+        };
+
+        // More threads than the hardware has are still worth running here,
+        // since being preempted in the middle of an add or a resize is one
+        // of the interleavings being checked.
+        unsigned int mostThreads = std::max(2 * threadCounts().back(), 8u);
+
+        for (unsigned int threads = 2; threads <= mostThreads; threads *= 2)
+        {
+            ConcurrentHashSet<std::string> set;
+            std::atomic<bool> failed{false};
+
+            reporter.report(throughput("concurrent-stress", "ConcurrentHashSet",
+                "threads=" + std::to_string(threads), threads,
+                [&](unsigned int thread) -> unsigned long long
+                {
+                    unsigned long long operations = 0;
+                    for (std::size_t i = thread; i < corpus.shuffled.size(); i += threads)
+                    {
+                        set.add(corpus.shuffled[i]);
+                        bool found = set.contains(corpus.shuffled[i]);
+                        bool missed = !set.contains(corpus.misses[i % corpus.misses.size()]);
+                        if (!found || !missed)
+                        {
+                            failed = true;
+                        }
+                        operations += 3;
+                    }
+                    return operations;
+                }));
+
+            std::string parameter = " with " + std::to_string(threads) + " threads";
+
+            if (failed)
+            {
+                fail("a lookup during the adds was wrong" + parameter);
+            }
+
+            // The retired tables are released between the two checks, so
+            // the second one also checks that nothing still live was freed.
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                if (set.size() != corpus.shuffled.size())
+                {
+                    fail("size is " + std::to_string(set.size()) + " rather than "
+                        + std::to_string(corpus.shuffled.size()) + parameter);
+                }
+
+                for (const std::string& word: corpus.shuffled)
+                {
+                    if (!set.contains(word))
+                    {
+                        fail("\"" + word + "\" was added but not found" + parameter);
+                    }
+                }
+
+                for (const std::string& word: corpus.misses)
+                {
+                    if (set.contains(word))
+                    {
+                        fail("\"" + word + "\" was found but never added" + parameter);
+                    }
+                }
+
+                set.releaseRetired();
+            }
+        }
+    }
+
+
+    Options parseOptions(int argc, char** argv)
+    {
+        Options options;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string argument = argv[i];
+
+            if (argument == "--json")
+            {
+                options.json = true;
+            }
+            else if (argument == "--words" && i + 1 < argc)
+            {
+                options.wordsPath = argv[++i];
+            }
+            else if (argument == "--count" && i + 1 < argc)
+            {
+                options.count = std::strtoul(argv[++i], nullptr, 10);
+            }
+            else if (argument == "--filter" && i + 1 < argc)
+            {
+                options.filter = argv[++i];
+            }
+            else
+            {
+                std::cerr << "usage: " << argv[0]
+                          << " [--words FILE] [--count N] [--filter TEXT] [--json]" << std::endl;
+                std::exit(2);
+            }
+        }
+
+        return options;
+    }
+}
+
+
+
+int main(int argc, char** argv)
+{
+    Options options = parseOptions(argc, argv);
+    Corpus corpus = loadCorpus(options);
+    Reporter reporter{options};
+
+    runCommonWorkloads(Contender<AVLSet<std::string>>{
+        "AVLSet", [] { return std::make_unique<AVLSet<std::string>>(); }}, corpus, reporter);
+    runCommonWorkloads(Contender<BPlusTreeSet<std::string>>{
+        "BPlusTreeSet", [] { return std::make_unique<BPlusTreeSet<std::string>>(); }}, corpus, reporter);
+    runCommonWorkloads(Contender<HashSet<std::string>>{
+        "HashSet", [] { return std::make_unique<HashSet<std::string>>(); }}, corpus, reporter);
+    runCommonWorkloads(Contender<HashSet<std::string>>{
+        "HashSet(incremental)", []
+        {
+            return std::make_unique<HashSet<std::string>>(
+                DefaultHasher<std::string>{}, std::equal_to<>{}, true);
+        }}, corpus, reporter);
+    runCommonWorkloads(Contender<FlatHashSet<std::string>>{
+        "FlatHashSet", [] { return std::make_unique<FlatHashSet<std::string>>(); }}, corpus, reporter);
+    runCommonWorkloads(Contender<ConcurrentHashSet<std::string>>{
+        "ConcurrentHashSet", [] { return std::make_unique<ConcurrentHashSet<std::string>>(); }},
+        corpus, reporter);
+
+    runLoadFactorWorkloads(corpus, reporter);
+    runBulkBuildWorkloads(corpus, reporter);
+    runDictionaryLoadWorkloads(corpus, reporter);
+    runRemoveWorkloads(corpus, reporter);
+    runStartupWorkloads(corpus, reporter);
+    runTraversalWorkloads(corpus, reporter);
+    runTreeWorkloads(corpus, reporter);
+    runInternedWorkloads(corpus, reporter);
+    runInternedEdgeChecks(reporter);
+    runFrozenWorkloads(corpus, reporter);
+    runEditDistanceWorkloads(corpus, reporter);
+    runSuggestionIndexWorkloads(corpus, reporter);
+    runAutocompleteWorkloads(corpus, reporter);
+    runFilterWorkloads(corpus, reporter);
+    runRollingHashWorkloads(corpus, reporter);
+    runBatchWorkloads(corpus, reporter);
+    runSuggestionCacheWorkloads(corpus, reporter);
+    runStreamWorkloads(corpus, reporter);
+    runConcurrentWorkloads(corpus, reporter);
+    runConcurrentStressWorkloads(corpus, reporter);
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+// BloomFilter.cpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Implementation of the BloomFilter class.
+
+#include "BloomFilter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include "HashPolicy.hpp"
+
+
+namespace
+{
+    // The proportion of extra bits given to a blocked filter to bring its
+    // false positive rate back down to what was asked for.
+    constexpr double BLOCKING_OVERHEAD = 1.2;
+
+
+    // A PolynomialHasher's 32-bit hash is spread over 64 bits with the
+    // finalizer from SplitMix64, so that the block (chosen by the high
+    // half) and the bits within it (chosen by the low half) don't depend
+    // on each other.
+    std::uint64_t widen(unsigned int hash) noexcept
+    {
+        std::uint64_t z = hash + 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+
+    // The i-th bit for a word within its block, found by double hashing
+    // from the low half of its hash; the high half chooses the block.
+    unsigned int bitFor(std::uint64_t hash, unsigned int i) noexcept
+    {
+        std::uint32_t h1 = static_cast<std::uint32_t>(hash);
+        std::uint32_t h2 = static_cast<std::uint32_t>((hash * 0x9E3779B97F4A7C15ull) >> 32) | 1;
+        return (h1 + i * h2) % BloomFilter::BLOCK_BITS;
+    }
+}
+
+
+BloomFilter::BloomFilter(std::size_t expectedCount, double falsePositiveRate, Hashing hashing)
+    : wordHashing{hashing}
+{
+    rate = std::min(std::max(falsePositiveRate, 0.0001), 0.5);
+
+    // An ordinary Bloom filter needs -ln(p) / ln(2)^2 bits per word, and
+    // does best with that many times ln(2) hashes.
+    const double ln2 = std::log(2.0);
+    double bitsPerWord = -std::log(rate) / (ln2 * ln2);
+    hashes = static_cast<unsigned int>(std::min(std::max(std::lround(bitsPerWord * ln2), 1l), 16l));
+
+    double bits = std::max(1.0, bitsPerWord * BLOCKING_OVERHEAD * expectedCount);
+    std::size_t blockCount = static_cast<std::size_t>(std::ceil(bits / BLOCK_BITS));
+    blocks.assign(blockCount, Block{});
+}
+
+
+void BloomFilter::add(std::string_view word) noexcept
+{
+    std::uint64_t hash = hashOf(word);
+    Block& block = blocks[blockIndex(hash)];
+
+    for (unsigned int i = 0; i < hashes; ++i)
+    {
+        unsigned int bit = bitFor(hash, i);
+        block.words[bit / 64] |= std::uint64_t{1} << (bit % 64);
+    }
+}
+
+
+bool BloomFilter::mightContain(std::string_view word) const noexcept
+{
+    return mightContainWide(hashOf(word));
+}
+
+
+bool BloomFilter::mightContainHash(unsigned int polynomialHash) const noexcept
+{
+    return mightContainWide(widen(polynomialHash));
+}
+
+
+BloomFilter::Hashing BloomFilter::hashing() const noexcept
+{
+    return wordHashing;
+}
+
+
+std::size_t BloomFilter::bitCount() const noexcept
+{
+    return blocks.size() * BLOCK_BITS;
+}
+
+
+unsigned int BloomFilter::hashCount() const noexcept
+{
+    return hashes;
+}
+
+
+double BloomFilter::falsePositiveRate() const noexcept
+{
+    return rate;
+}
+
+
+std::uint64_t BloomFilter::hashOf(std::string_view word) const noexcept
+{
+    if (wordHashing == Hashing::Polynomial)
+    {
+        return widen(PolynomialHasher{}(word));
+    }
+
+    return std::hash<std::string_view>{}(word);
+}
+
+
+bool BloomFilter::mightContainWide(std::uint64_t hash) const noexcept
+{
+    const Block& block = blocks[blockIndex(hash)];
+
+    for (unsigned int i = 0; i < hashes; ++i)
+    {
+        unsigned int bit = bitFor(hash, i);
+        if ((block.words[bit / 64] & (std::uint64_t{1} << (bit % 64))) == 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+std::size_t BloomFilter::blockIndex(std::uint64_t hash) const noexcept
+{
+    // Multiplying the high half of the hash by the number of blocks and
+    // keeping the high half of the product maps it evenly onto the blocks
+    // without a division.
+    std::uint64_t high = hash >> 32;
+    return static_cast<std::size_t>((high * blocks.size()) >> 32);
+}
@@ -0,0 +1,140 @@
+// BloomFilter.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A BloomFilter is a compact summary of a set of words that can say for
+// certain that a word is not in the set, but can only say that a word
+// might be.  A WordChecker can consult one before its Set (see
+// WordChecker::setFilter()), so that most of the misspelled candidates
+// generated by findSuggestions() are rejected without a lookup in the Set
+// at all.
+//
+// This is a "blocked" Bloom filter: the bits are divided into blocks the
+// size of a cache line, and all of the bits for a given word are in the
+// same block, so checking a word reads exactly one cache line.  This makes
+// the false positive rate slightly higher than an ordinary Bloom filter of
+// the same size would have; it's made up for by giving the filter a few
+// more bits per word than the usual formula calls for.
+//
+// Words can only be added, never removed.  A BloomFilter uses std::hash
+// unless it's built to hash words as a PolynomialHasher does (see
+// HashPolicy.hpp), in which case a caller that already has a word's hash
+// can check it with mightContainHash() without hashing it again.
+// WordChecker::findSuggestions() does that when its Set is a
+// PolynomialHashLookup, since it finds its candidates' hashes in constant
+// time, and a filter that had to hash every candidate would make that
+// O(n) again.  std::hash is faster for a word given on its own, so it's
+// the better choice for any other Set.  Either way, a filter can't be
+// saved and used by another process.
+
+#ifndef BLOOMFILTER_HPP
+#define BLOOMFILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+
+
+class BloomFilter
+{
+public:
+    // The false positive rate a BloomFilter is built for when none is
+    // specified.
+    static constexpr double DEFAULT_FALSE_POSITIVE_RATE = 0.01;
+
+    // The number of bits in each block, which is one cache line.
+    static constexpr unsigned int BLOCK_BITS = 512;
+
+    // Hashing is how a BloomFilter hashes words: with std::hash, or as a
+    // PolynomialHasher does.
+    enum class Hashing
+    {
+        Standard,
+        Polynomial
+    };
+
+public:
+    // Initializes an empty BloomFilter sized so that, once expectedCount
+    // words have been added to it, the proportion of other words that it
+    // mistakes for ones that were added is about falsePositiveRate.  The
+    // rate is clamped to be between 0.0001 and 0.5.
+    explicit BloomFilter(
+        std::size_t expectedCount,
+        double falsePositiveRate = DEFAULT_FALSE_POSITIVE_RATE,
+        Hashing hashing = Hashing::Standard);
+
+    // Initializes a BloomFilter containing the words in the range
+    // [first, last), sized for exactly that many words.
+    template <typename ForwardIterator>
+    BloomFilter(
+        ForwardIterator first, ForwardIterator last,
+        double falsePositiveRate = DEFAULT_FALSE_POSITIVE_RATE,
+        Hashing hashing = Hashing::Standard);
+
+
+    // add() adds a word to the filter.
+    void add(std::string_view word) noexcept;
+
+
+    // mightContain() returns false if the given word was certainly never
+    // added to the filter, or true if it may have been.
+    bool mightContain(std::string_view word) const noexcept;
+
+    // mightContainHash() is like mightContain(), but is given the hash
+    // that a PolynomialHasher would return for the word, rather than the
+    // word itself.  It can only be called on a filter whose hashing is
+    // Hashing::Polynomial.
+    bool mightContainHash(unsigned int polynomialHash) const noexcept;
+
+
+    // hashing() returns how the filter hashes words.
+    Hashing hashing() const noexcept;
+
+
+    // bitCount() returns the total number of bits in the filter, and
+    // hashCount() returns the number of bits set for each word.
+    std::size_t bitCount() const noexcept;
+    unsigned int hashCount() const noexcept;
+
+
+    // falsePositiveRate() returns the false positive rate the filter was
+    // built for.
+    double falsePositiveRate() const noexcept;
+
+
+private:
+    struct alignas(64) Block
+    {
+        std::uint64_t words[BLOCK_BITS / 64];
+    };
+
+    std::vector<Block> blocks;
+    unsigned int hashes;
+    double rate;
+    Hashing wordHashing;
+
+    std::uint64_t hashOf(std::string_view word) const noexcept;
+    std::size_t blockIndex(std::uint64_t hash) const noexcept;
+    bool mightContainWide(std::uint64_t hash) const noexcept;
+};
+
+
+
+template <typename ForwardIterator>
+BloomFilter::BloomFilter(
+    ForwardIterator first, ForwardIterator last, double falsePositiveRate, Hashing hashing)
+    : BloomFilter(static_cast<std::size_t>(std::distance(first, last)), falsePositiveRate, hashing)
+{
+    for (; first != last; ++first)
+    {
+        add(*first);
+    }
+}
+
+
+
+#endif
@@ -0,0 +1,428 @@
+// ConcurrentHashSet.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A ConcurrentHashSet is a separately-chained hash table, like HashSet,
+// that any number of threads can add to and look up in at the same time.
+//
+//     * Adding an element locks only one of STRIPE_COUNT "stripes", each
+//       of which guards every cell whose index is congruent to it, so adds
+//       to different parts of the array don't wait for each other.
+//     * Looking up an element takes no lock at all.  A node is fully built
+//       before it's published at the front of its chain, and it's never
+//       changed after that, so a reader following a chain always sees
+//       complete nodes.
+//     * Resizing locks every stripe and builds an entirely new array of
+//       new nodes, which is then published in one step.  Readers already
+//       walking the old array carry on safely, because the old array and
+//       its nodes are kept until the set is destroyed, or until
+//       releaseRetired() is called at a moment when no other thread is
+//       using the set.  Since the array more than doubles each time, the
+//       retired arrays and nodes never take up more space than the
+//       current ones, but that still means a set that has grown can use
+//       up to twice the memory its elements need.
+//
+// Like HashSet, the nodes store their element's full hash and are
+// allocated from NodePools, one per stripe and guarded by its lock.
+// Because of the locks it holds, a ConcurrentHashSet can be neither copied
+// nor moved.
+
+#ifndef CONCURRENTHASHSET_HPP
+#define CONCURRENTHASHSET_HPP
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include "HashPolicy.hpp"
+#include "ModificationCounted.hpp"
+#include "NodePool.hpp"
+#include "Set.hpp"
+
+
+
+template <
+    typename ElementType,
+    typename Hasher = DefaultHasher<ElementType>,
+    typename KeyEqual = std::equal_to<>>
+class ConcurrentHashSet : public Set<ElementType>, public ModificationCounted
+{
+public:
+    // The default capacity of the ConcurrentHashSet before anything has
+    // been added to it.
+    static constexpr unsigned int DEFAULT_CAPACITY = 10;
+
+    // The number of locks that the cells of the array are divided between.
+    static constexpr unsigned int STRIPE_COUNT = 64;
+
+    // A HashFunction is a function that takes a reference to a const
+    // ElementType and returns an unsigned int.
+    using HashFunction = std::function<unsigned int(const ElementType&)>;
+
+public:
+    // Initializes a ConcurrentHashSet to be empty, so that it will use the
+    // given hash function whenever it needs to hash an element.  This
+    // requires that a Hasher can be constructed from a HashFunction, as a
+    // DefaultHasher can (see HashPolicy.hpp).
+    explicit ConcurrentHashSet(HashFunction hashFunction);
+
+    // Initializes a ConcurrentHashSet to be empty, so that it will use the
+    // given hasher and key equal objects whenever it needs to hash or
+    // compare elements.
+    explicit ConcurrentHashSet(
+        const Hasher& hasher = Hasher(),
+        const KeyEqual& keyEqual = KeyEqual());
+
+    // Cleans up the ConcurrentHashSet so that it leaks no memory.  No
+    // other thread may be using it by then.
+    ~ConcurrentHashSet() noexcept override;
+
+    ConcurrentHashSet(const ConcurrentHashSet& s) = delete;
+    ConcurrentHashSet& operator=(const ConcurrentHashSet& s) = delete;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() adds an element to the set.  If the element is already in the
+    // set, this function has no effect.  It's safe to call from any number
+    // of threads at once, along with contains() and size().  When the ratio
+    // of size to capacity would exceed 0.8, the array is resized to
+    //
+    //     capacity * 2 + 1
+    //
+    // in which case this function runs in linear time; otherwise, it runs
+    // in constant time (assuming a good hash function and not counting time
+    // spent waiting for another thread's resize).
+    void add(const ElementType& element) override;
+
+
+    // contains() returns true if the given element is already in the set,
+    // false otherwise.  It never takes a lock.  An element being added by
+    // another thread at the same time may or may not be found.
+    bool contains(const ElementType& element) const override;
+
+
+    // size() returns the number of elements in the set.
+    unsigned int size() const noexcept override;
+
+
+    // modificationCount() returns the number of elements added since the
+    // set was built (see ModificationCounted.hpp).  Since elements are never
+    // removed, and the set can't be assigned to, that's just its size.
+    std::uint64_t modificationCount() const noexcept override;
+
+
+    // getCapacity() returns the size of the current array.
+    unsigned int getCapacity() const noexcept;
+
+
+    // releaseRetired() destroys the arrays and nodes left behind by earlier
+    // resizes, giving the nodes back to their pools to be reused by later
+    // adds.  Unlike the other member functions, it must not be called while
+    // any other thread is using the set, such as once a burst of
+    // concurrent adds has been joined.  It runs in linear time.
+    void releaseRetired() noexcept;
+
+
+private:
+    struct Node
+    {
+        ElementType value;
+        unsigned int hash;
+        Node* next;
+    };
+
+    // Each table is an array of cells along with its capacity, and a link
+    // to the table that was retired before it.
+    struct Table
+    {
+        unsigned int capacity;
+        std::atomic<Node*>* cells;
+        Table* previous;
+    };
+
+    // Each stripe sits on its own cache line, so that threads locking
+    // neighbouring stripes don't slow each other down.
+    struct alignas(64) Stripe
+    {
+        std::mutex mutex;
+        NodePool<Node> pool;
+    };
+
+    Hasher hasher;
+    KeyEqual keyEqual;
+
+    std::atomic<Table*> table;
+    std::atomic<unsigned int> concurrentSize;
+    Stripe stripes[STRIPE_COUNT];
+
+    static Table* createTable(unsigned int capacity, Table* previous);
+    bool find(const Table* current, const ElementType& element, unsigned int hash) const;
+    void resize(unsigned int expectedCapacity);
+};
+
+
+
+// A ConcurrentHashSet constructed from a HashFunction is the usual kind
+// of ConcurrentHashSet, whose DefaultHasher calls the HashFunction.
+template <typename ElementType>
+ConcurrentHashSet(std::function<unsigned int(const ElementType&)>)
+    -> ConcurrentHashSet<ElementType>;
+
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+ConcurrentHashSet<ElementType, Hasher, KeyEqual>::ConcurrentHashSet(HashFunction hashFunction)
+    : hasher{hashFunction}, keyEqual{},
+      table{createTable(DEFAULT_CAPACITY, nullptr)}, concurrentSize{0}
+{
+    static_assert(
+        std::is_constructible<Hasher, HashFunction>::value,
+        "a ConcurrentHashSet given a HashFunction needs a Hasher such as DefaultHasher<ElementType>");
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+ConcurrentHashSet<ElementType, Hasher, KeyEqual>::ConcurrentHashSet(
+    const Hasher& hasher, const KeyEqual& keyEqual)
+    : hasher{hasher}, keyEqual{keyEqual},
+      table{createTable(DEFAULT_CAPACITY, nullptr)}, concurrentSize{0}
+{
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+ConcurrentHashSet<ElementType, Hasher, KeyEqual>::~ConcurrentHashSet() noexcept
+{
+    // Every node belongs to exactly one table, current or retired, so each
+    // one's destructor runs exactly once here; their space is given back
+    // when the stripes' pools are destroyed.
+    Table* current = table.load();
+
+    while (current != nullptr)
+    {
+        if constexpr (!std::is_trivially_destructible<Node>::value)
+        {
+            for (unsigned int i = 0; i < current->capacity; ++i)
+            {
+                Node* node = current->cells[i].load(std::memory_order_relaxed);
+                while (node != nullptr)
+                {
+                    Node* next = node->next;
+                    node->~Node();
+                    node = next;
+                }
+            }
+        }
+
+        Table* previous = current->previous;
+        delete[] current->cells;
+        delete current;
+        current = previous;
+    }
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool ConcurrentHashSet<ElementType, Hasher, KeyEqual>::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void ConcurrentHashSet<ElementType, Hasher, KeyEqual>::add(const ElementType& element)
+{
+    unsigned int hash = hasher(element);
+    unsigned int newSize;
+    unsigned int capacity;
+
+    while (true)
+    {
+        Table* current = table.load(std::memory_order_acquire);
+        unsigned int index = hash % current->capacity;
+        Stripe& stripe = stripes[index % STRIPE_COUNT];
+        std::lock_guard<std::mutex> lock{stripe.mutex};
+
+        // A resize needs every stripe's lock, so once we hold one, the
+        // table can't change underneath us; but it might have changed
+        // between loading it and locking, in which case the index we
+        // locked for is stale.
+        if (current != table.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+
+        if (find(current, element, hash))
+        {
+            return;
+        }
+
+        std::atomic<Node*>& cell = current->cells[index];
+        Node* add = stripe.pool.create(element, hash, cell.load(std::memory_order_relaxed));
+        cell.store(add, std::memory_order_release);
+
+        newSize = concurrentSize.fetch_add(1, std::memory_order_relaxed) + 1;
+        capacity = current->capacity;
+        break;
+    }
+
+    if (newSize > 0.8 * capacity)
+    {
+        resize(capacity);
+    }
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool ConcurrentHashSet<ElementType, Hasher, KeyEqual>::contains(const ElementType& element) const
+{
+    return find(table.load(std::memory_order_acquire), element, hasher(element));
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+unsigned int ConcurrentHashSet<ElementType, Hasher, KeyEqual>::size() const noexcept
+{
+    return concurrentSize.load(std::memory_order_relaxed);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+std::uint64_t ConcurrentHashSet<ElementType, Hasher, KeyEqual>::modificationCount() const noexcept
+{
+    return size();
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+unsigned int ConcurrentHashSet<ElementType, Hasher, KeyEqual>::getCapacity() const noexcept
+{
+    return table.load(std::memory_order_acquire)->capacity;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void ConcurrentHashSet<ElementType, Hasher, KeyEqual>::releaseRetired() noexcept
+{
+    // A node in cell i of any table came from stripe i's pool, whether it
+    // was added there or copied there by a resize.
+    Table* current = table.load(std::memory_order_acquire);
+    Table* retired = current->previous;
+    current->previous = nullptr;
+
+    while (retired != nullptr)
+    {
+        for (unsigned int i = 0; i < retired->capacity; ++i)
+        {
+            Node* node = retired->cells[i].load(std::memory_order_relaxed);
+            while (node != nullptr)
+            {
+                Node* next = node->next;
+                stripes[i % STRIPE_COUNT].pool.destroy(node);
+                node = next;
+            }
+        }
+
+        Table* previous = retired->previous;
+        delete[] retired->cells;
+        delete retired;
+        retired = previous;
+    }
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+typename ConcurrentHashSet<ElementType, Hasher, KeyEqual>::Table*
+ConcurrentHashSet<ElementType, Hasher, KeyEqual>::createTable(unsigned int capacity, Table* previous)
+{
+    Table* created = new Table{capacity, new std::atomic<Node*>[capacity], previous};
+    for (unsigned int i = 0; i < capacity; ++i)
+    {
+        created->cells[i].store(nullptr, std::memory_order_relaxed);
+    }
+    return created;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool ConcurrentHashSet<ElementType, Hasher, KeyEqual>::find(
+    const Table* current, const ElementType& element, unsigned int hash) const
+{
+    Node* find = current->cells[hash % current->capacity].load(std::memory_order_acquire);
+
+    for (; find != nullptr; find = find->next)
+    {
+        if (find->hash == hash && keyEqual(find->value, element))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void ConcurrentHashSet<ElementType, Hasher, KeyEqual>::resize(unsigned int expectedCapacity)
+{
+    // The stripes are always locked in the same order, so two threads
+    // resizing at once can't deadlock; the second one finds that the
+    // capacity has already changed and does nothing.
+    std::unique_lock<std::mutex> locks[STRIPE_COUNT];
+    for (unsigned int i = 0; i < STRIPE_COUNT; ++i)
+    {
+        locks[i] = std::unique_lock<std::mutex>{stripes[i].mutex};
+    }
+
+    Table* current = table.load(std::memory_order_relaxed);
+
+    if (current->capacity != expectedCapacity)
+    {
+        return;
+    }
+
+    Table* resized = createTable(current->capacity * 2 + 1, current);
+
+    try
+    {
+        for (unsigned int i = 0; i < current->capacity; ++i)
+        {
+            Node* old = current->cells[i].load(std::memory_order_relaxed);
+            for (; old != nullptr; old = old->next)
+            {
+                unsigned int index = old->hash % resized->capacity;
+                std::atomic<Node*>& cell = resized->cells[index];
+                Node* copy = stripes[index % STRIPE_COUNT].pool.create(
+                    old->value, old->hash, cell.load(std::memory_order_relaxed));
+                cell.store(copy, std::memory_order_relaxed);
+            }
+        }
+    }
+    catch (...)
+    {
+        // Nobody else has seen the new table, so its nodes can go straight
+        // back to their pools; the set carries on with the old table.
+        for (unsigned int i = 0; i < resized->capacity; ++i)
+        {
+            Node* node = resized->cells[i].load(std::memory_order_relaxed);
+            while (node != nullptr)
+            {
+                Node* next = node->next;
+                stripes[i % STRIPE_COUNT].pool.destroy(node);
+                node = next;
+            }
+        }
+
+        delete[] resized->cells;
+        delete resized;
+        throw;
+    }
+
+    table.store(resized, std::memory_order_release);
+}
+
+
+#endif
@@ -0,0 +1,597 @@
+// FlatHashSet.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A FlatHashSet is an implementation of a Set that is an open-addressed
+// hash table.  Rather than following a linked list of separately allocated
+// nodes like HashSet does, the elements are stored directly in one
+// contiguous array of slots, alongside a parallel array of one-byte
+// "control" values describing each slot:
+//
+//     * EMPTY (0x80), meaning that the slot holds no element
+//     * 0x00 - 0x7F, meaning that the slot is full, with the value being
+//       seven bits taken from the element's hash
+//
+// The slots are divided into groups of sixteen.  A lookup hashes the
+// element once, picks a starting group, and then compares all sixteen
+// control bytes of the group against the element's seven hash bits at
+// once (using SSE2 when it's available), only comparing elements whose
+// control byte matched.  Seeing an EMPTY control byte in a group ends the
+// search, so most lookups touch one group of control bytes and a single
+// slot.
+//
+// As elements are added and the proportion of the FlatHashSet's size to
+// its capacity would exceed the maximum load factor (0.875 by default,
+// configurable in the constructor), the FlatHashSet is resized so that it
+// is twice as large as it was before.  The capacity is always a multiple
+// of sixteen whose number of groups is a power of two.
+//
+// Like HashSet, a FlatHashSet is templated on its hasher and key equal
+// types (see HashPolicy.hpp), and keeps each element's full hash in a
+// third array, so that growing never calls the hash function again.  The
+// array of slots is raw storage, in which an element is only constructed
+// when it's added, so the empty slots cost no constructor calls and need
+// ElementType to have no default constructor.
+
+#ifndef FLATHASHSET_HPP
+#define FLATHASHSET_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "HashPolicy.hpp"
+#include "ModificationCounted.hpp"
+#include "Set.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+
+template <
+    typename ElementType,
+    typename Hasher = DefaultHasher<ElementType>,
+    typename KeyEqual = std::equal_to<>>
+class FlatHashSet : public Set<ElementType>, public ModificationCounted
+{
+public:
+    // The default capacity of the FlatHashSet before anything has been
+    // added to it.  This is always exactly one group.
+    static constexpr unsigned int DEFAULT_CAPACITY = 16;
+
+    // The default proportion of size to capacity beyond which the
+    // FlatHashSet is resized.
+    static constexpr double DEFAULT_MAX_LOAD_FACTOR = 0.875;
+
+    // A HashFunction is a function that takes a reference to a const
+    // ElementType and returns an unsigned int.
+    using HashFunction = std::function<unsigned int(const ElementType&)>;
+
+public:
+    // Initializes a FlatHashSet to be empty, so that it will use the given
+    // hash function whenever it needs to hash an element.  The maximum
+    // load factor is clamped to the range [0.25, 0.95], so that there is
+    // always at least one EMPTY slot to end a search.  This requires that
+    // a Hasher can be constructed from a HashFunction, as a DefaultHasher
+    // can (see HashPolicy.hpp).
+    explicit FlatHashSet(
+        HashFunction hashFunction,
+        double maxLoadFactor = DEFAULT_MAX_LOAD_FACTOR);
+
+    // Initializes a FlatHashSet to be empty, so that it will use the given
+    // hasher and key equal objects whenever it needs to hash or compare
+    // elements.
+    explicit FlatHashSet(
+        const Hasher& hasher = Hasher(),
+        const KeyEqual& keyEqual = KeyEqual(),
+        double maxLoadFactor = DEFAULT_MAX_LOAD_FACTOR);
+
+    // Cleans up the FlatHashSet so that it leaks no memory.
+    ~FlatHashSet() noexcept override;
+
+    // Initializes a new FlatHashSet to be a copy of an existing one.
+    FlatHashSet(const FlatHashSet& s);
+
+    // Initializes a new FlatHashSet whose contents are moved from an
+    // expiring one.
+    FlatHashSet(FlatHashSet&& s) noexcept;
+
+    // Assigns an existing FlatHashSet into another.
+    FlatHashSet& operator=(const FlatHashSet& s);
+
+    // Assigns an expiring FlatHashSet into another.
+    FlatHashSet& operator=(FlatHashSet&& s) noexcept;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() adds an element to the set.  If the element is already in the
+    // set, this function has no effect.  If adding the element would make
+    // the ratio of size to capacity exceed the maximum load factor, the
+    // array is first doubled in size, in which case this function runs in
+    // linear time; otherwise, it runs in constant time (assuming a good
+    // hash function).  The amortized running time is also constant.
+    void add(const ElementType& element) override;
+
+
+    // contains() returns true if the given element is already in the set,
+    // false otherwise.  This function runs in constant time (with respect
+    // to the number of elements, assuming a good hash function).
+    bool contains(const ElementType& element) const override;
+
+
+    // size() returns the number of elements in the set.
+    unsigned int size() const noexcept override;
+
+
+    // modificationCount() returns the number of elements added since the
+    // set was built (see ModificationCounted.hpp).
+    std::uint64_t modificationCount() const noexcept override;
+
+
+    // getCapacity() returns the number of slots in the array.
+    unsigned int getCapacity() const noexcept;
+
+
+    // loadFactor() returns the proportion of the slots that are full.
+    double loadFactor() const noexcept;
+
+
+private:
+    static constexpr unsigned int GROUP_WIDTH = 16;
+    static constexpr signed char EMPTY = -128;
+
+    Hasher hasher;
+    KeyEqual keyEqual;
+    double maxLoadFactor;
+
+    unsigned int flatSize;
+    unsigned int flatCapacity;
+    signed char* control;
+    ElementType* slots;
+    unsigned int* hashes;
+    ModificationCounter modifications;
+
+    // A Probe describes where a hash's search starts and the seven bits
+    // that its control bytes will hold.
+    struct Probe
+    {
+        unsigned int group;
+        signed char tag;
+    };
+
+    static Probe probeFor(unsigned int hash) noexcept;
+    unsigned int groupCount() const noexcept;
+
+    // These return a bitmask with bit i set when control byte i of the
+    // group starting at the given slot matches the condition.
+    std::uint32_t matchTag(unsigned int first, signed char tag) const noexcept;
+    std::uint32_t matchEmpty(unsigned int first) const noexcept;
+
+    bool find(const ElementType& element, Probe probe) const;
+    unsigned int findEmpty(Probe probe) const noexcept;
+    void allocate(unsigned int capacity);
+    void release() noexcept;
+    static void destroy(
+        signed char* control, ElementType* slots, unsigned int* hashes,
+        unsigned int capacity) noexcept;
+    void copyFrom(const FlatHashSet& s);
+    void grow();
+};
+
+
+
+// A FlatHashSet constructed from a HashFunction is the usual kind of FlatHashSet,
+// whose DefaultHasher calls the HashFunction.
+template <typename ElementType>
+FlatHashSet(std::function<unsigned int(const ElementType&)>, double = 0.875)
+    -> FlatHashSet<ElementType>;
+
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FlatHashSet<ElementType, Hasher, KeyEqual>::FlatHashSet(
+    HashFunction hashFunction, double maxLoadFactor)
+    : hasher{hashFunction}, keyEqual{},
+      maxLoadFactor{std::min(std::max(maxLoadFactor, 0.25), 0.95)}
+{
+    static_assert(
+        std::is_constructible<Hasher, HashFunction>::value,
+        "a FlatHashSet given a HashFunction needs a Hasher such as DefaultHasher<ElementType>");
+
+    allocate(DEFAULT_CAPACITY);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FlatHashSet<ElementType, Hasher, KeyEqual>::FlatHashSet(
+    const Hasher& hasher, const KeyEqual& keyEqual, double maxLoadFactor)
+    : hasher{hasher}, keyEqual{keyEqual},
+      maxLoadFactor{std::min(std::max(maxLoadFactor, 0.25), 0.95)}
+{
+    allocate(DEFAULT_CAPACITY);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FlatHashSet<ElementType, Hasher, KeyEqual>::~FlatHashSet() noexcept
+{
+    release();
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FlatHashSet<ElementType, Hasher, KeyEqual>::FlatHashSet(const FlatHashSet& s)
+    : hasher{s.hasher}, keyEqual{s.keyEqual}, maxLoadFactor{s.maxLoadFactor}
+{
+    copyFrom(s);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FlatHashSet<ElementType, Hasher, KeyEqual>::FlatHashSet(FlatHashSet&& s) noexcept
+    : hasher{s.hasher}, keyEqual{s.keyEqual}, maxLoadFactor{s.maxLoadFactor}
+{
+    allocate(DEFAULT_CAPACITY);
+
+    std::swap(flatSize, s.flatSize);
+    std::swap(flatCapacity, s.flatCapacity);
+    std::swap(control, s.control);
+    std::swap(slots, s.slots);
+    std::swap(hashes, s.hashes);
+    s.modifications.bump();
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FlatHashSet<ElementType, Hasher, KeyEqual>& FlatHashSet<ElementType, Hasher, KeyEqual>::operator=(const FlatHashSet& s)
+{
+    // The copy is made before anything is released, so a copy that throws
+    // leaves this FlatHashSet as it was.
+    if (this != &s)
+    {
+        FlatHashSet copy{s};
+        *this = std::move(copy);
+    }
+
+    return *this;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FlatHashSet<ElementType, Hasher, KeyEqual>& FlatHashSet<ElementType, Hasher, KeyEqual>::operator=(FlatHashSet&& s) noexcept
+{
+    std::swap(hasher, s.hasher);
+    std::swap(keyEqual, s.keyEqual);
+    std::swap(maxLoadFactor, s.maxLoadFactor);
+    std::swap(flatSize, s.flatSize);
+    std::swap(flatCapacity, s.flatCapacity);
+    std::swap(control, s.control);
+    std::swap(slots, s.slots);
+    std::swap(hashes, s.hashes);
+    modifications.bump();
+    s.modifications.bump();
+    return *this;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool FlatHashSet<ElementType, Hasher, KeyEqual>::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void FlatHashSet<ElementType, Hasher, KeyEqual>::add(const ElementType& element)
+{
+    unsigned int hash = hasher(element);
+    Probe probe = probeFor(hash);
+
+    if (find(element, probe))
+    {
+        return;
+    }
+
+    if (flatSize + 1 > maxLoadFactor * flatCapacity)
+    {
+        grow();
+    }
+
+    // The control byte is only set once the element has been constructed,
+    // so a constructor that throws leaves the slot empty.
+    unsigned int slot = findEmpty(probe);
+    ::new (static_cast<void*>(slots + slot)) ElementType{element};
+    control[slot] = probe.tag;
+    hashes[slot] = hash;
+    flatSize += 1;
+    modifications.bump();
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool FlatHashSet<ElementType, Hasher, KeyEqual>::contains(const ElementType& element) const
+{
+    return find(element, probeFor(hasher(element)));
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool FlatHashSet<ElementType, Hasher, KeyEqual>::find(const ElementType& element, Probe probe) const
+{
+    unsigned int mask = groupCount() - 1;
+    unsigned int group = probe.group & mask;
+
+    for (unsigned int step = 1; step <= groupCount(); ++step)
+    {
+        unsigned int first = group * GROUP_WIDTH;
+
+        for (std::uint32_t match = matchTag(first, probe.tag); match != 0; match &= match - 1)
+        {
+            if (keyEqual(slots[first + __builtin_ctz(match)], element))
+            {
+                return true;
+            }
+        }
+
+        if (matchEmpty(first) != 0)
+        {
+            return false;
+        }
+
+        group = (group + step) & mask;
+    }
+
+    return false;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+unsigned int FlatHashSet<ElementType, Hasher, KeyEqual>::size() const noexcept
+{
+    return flatSize;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+std::uint64_t FlatHashSet<ElementType, Hasher, KeyEqual>::modificationCount() const noexcept
+{
+    return modifications.value();
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+unsigned int FlatHashSet<ElementType, Hasher, KeyEqual>::getCapacity() const noexcept
+{
+    return flatCapacity;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+double FlatHashSet<ElementType, Hasher, KeyEqual>::loadFactor() const noexcept
+{
+    return static_cast<double>(flatSize) / flatCapacity;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+typename FlatHashSet<ElementType, Hasher, KeyEqual>::Probe FlatHashSet<ElementType, Hasher, KeyEqual>::probeFor(
+    unsigned int hash) noexcept
+{
+    // The hash function is only promised to return an unsigned int, and
+    // the ones used with this project are often weak in their low bits,
+    // so the hash is spread with a multiplication before its bits are
+    // divided up between the group index and the tag.
+    std::uint64_t mixed = static_cast<std::uint64_t>(hash)
+        * 0x9E3779B97F4A7C15ull;
+
+    Probe probe;
+    probe.group = static_cast<unsigned int>(mixed >> 32);
+    probe.tag = static_cast<signed char>((mixed >> 25) & 0x7F);
+    return probe;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+unsigned int FlatHashSet<ElementType, Hasher, KeyEqual>::groupCount() const noexcept
+{
+    return flatCapacity / GROUP_WIDTH;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+std::uint32_t FlatHashSet<ElementType, Hasher, KeyEqual>::matchTag(
+    unsigned int first, signed char tag) const noexcept
+{
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control + first));
+    return static_cast<std::uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag))));
+#else
+    std::uint32_t match = 0;
+    for (unsigned int i = 0; i < GROUP_WIDTH; ++i)
+    {
+        if (control[first + i] == tag)
+        {
+            match |= 1u << i;
+        }
+    }
+    return match;
+#endif
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+std::uint32_t FlatHashSet<ElementType, Hasher, KeyEqual>::matchEmpty(unsigned int first) const noexcept
+{
+    // EMPTY is the only negative control byte, so the sign bits are
+    // exactly the ones we're looking for.
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control + first));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(group));
+#else
+    return matchTag(first, EMPTY);
+#endif
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+unsigned int FlatHashSet<ElementType, Hasher, KeyEqual>::findEmpty(Probe probe) const noexcept
+{
+    // The load factor is capped below 1, so some group along the probe
+    // sequence always has an empty slot; the triangular steps visit
+    // every group when the number of groups is a power of two.
+    unsigned int mask = groupCount() - 1;
+    unsigned int group = probe.group & mask;
+
+    for (unsigned int step = 1; ; ++step)
+    {
+        unsigned int first = group * GROUP_WIDTH;
+        std::uint32_t match = matchEmpty(first);
+
+        if (match != 0)
+        {
+            return first + __builtin_ctz(match);
+        }
+
+        group = (group + step) & mask;
+    }
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void FlatHashSet<ElementType, Hasher, KeyEqual>::allocate(unsigned int capacity)
+{
+    // Nothing is changed until all three arrays have been allocated, so
+    // the FlatHashSet is left as it was if one of them can't be.
+    std::unique_ptr<signed char[]> newControl{new signed char[capacity]};
+    std::unique_ptr<unsigned int[]> newHashes{new unsigned int[capacity]};
+    slots = std::allocator<ElementType>{}.allocate(capacity);
+    control = newControl.release();
+    hashes = newHashes.release();
+    flatSize = 0;
+    flatCapacity = capacity;
+
+    std::fill(control, control + flatCapacity, EMPTY);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void FlatHashSet<ElementType, Hasher, KeyEqual>::release() noexcept
+{
+    destroy(control, slots, hashes, flatCapacity);
+    flatSize = 0;
+    flatCapacity = 0;
+    control = nullptr;
+    slots = nullptr;
+    hashes = nullptr;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void FlatHashSet<ElementType, Hasher, KeyEqual>::destroy(
+    signed char* control, ElementType* slots, unsigned int* hashes,
+    unsigned int capacity) noexcept
+{
+    // Only the full slots hold elements that need destroying.
+    if (control != nullptr)
+    {
+        for (unsigned int i = 0; i < capacity; ++i)
+        {
+            if (control[i] >= 0)
+            {
+                slots[i].~ElementType();
+            }
+        }
+
+        std::allocator<ElementType>{}.deallocate(slots, capacity);
+    }
+
+    delete[] control;
+    delete[] hashes;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void FlatHashSet<ElementType, Hasher, KeyEqual>::copyFrom(const FlatHashSet& s)
+{
+    // Each control byte is copied only after its element has been, so if
+    // copying an element throws, release() finds exactly the elements
+    // that need destroying.
+    allocate(s.flatCapacity);
+
+    try
+    {
+        for (unsigned int i = 0; i < flatCapacity; ++i)
+        {
+            if (s.control[i] >= 0)
+            {
+                ::new (static_cast<void*>(slots + i)) ElementType{s.slots[i]};
+                control[i] = s.control[i];
+                hashes[i] = s.hashes[i];
+            }
+        }
+    }
+    catch (...)
+    {
+        release();
+        throw;
+    }
+
+    flatSize = s.flatSize;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void FlatHashSet<ElementType, Hasher, KeyEqual>::grow()
+{
+    unsigned int oldCapacity = flatCapacity;
+    unsigned int oldSize = flatSize;
+    signed char* oldControl = control;
+    ElementType* oldSlots = slots;
+    unsigned int* oldHashes = hashes;
+
+    allocate(oldCapacity * 2);
+
+    // The elements are moved unless moving one could throw, in which case
+    // they're copied, so that the old array is still intact to go back to
+    // if something goes wrong.
+    try
+    {
+        for (unsigned int i = 0; i < oldCapacity; ++i)
+        {
+            if (oldControl[i] >= 0)
+            {
+                Probe probe = probeFor(oldHashes[i]);
+                unsigned int slot = findEmpty(probe);
+                ::new (static_cast<void*>(slots + slot)) ElementType{std::move_if_noexcept(oldSlots[i])};
+                control[slot] = probe.tag;
+                hashes[slot] = oldHashes[i];
+                flatSize += 1;
+            }
+        }
+    }
+    catch (...)
+    {
+        release();
+        flatSize = oldSize;
+        flatCapacity = oldCapacity;
+        control = oldControl;
+        slots = oldSlots;
+        hashes = oldHashes;
+        throw;
+    }
+
+    destroy(oldControl, oldSlots, oldHashes, oldCapacity);
+}
+
+
+
+#endif
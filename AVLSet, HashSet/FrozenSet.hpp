@@ -0,0 +1,495 @@
+// FrozenSet.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A FrozenSet is an immutable implementation of a Set, built once from a
+// range of elements (or from a HashSet, with freeze()) and never changed
+// afterward.  Since its elements are all known up front, it can
+// use a "minimal perfect hash function": one that maps each of its n
+// elements to a different one of exactly n slots.  A lookup hashes the
+// element, looks in the one slot it maps to, and compares the element
+// there with the one it's looking for -- no chains, no probing, and no
+// empty slots.
+//
+// The perfect hash function is built in the way PTHash builds one.  The
+// elements are divided into buckets of about BUCKET_SIZE each, by hash.
+// Each bucket is given a "pilot" value, and an element's slot is found by
+// mixing its hash with its bucket's pilot.  The buckets are handled from
+// the largest to the smallest, and each is given the first pilot that
+// sends all of its elements to slots that are still free.  The only space
+// the function needs is one pilot per bucket, about one byte per element.
+//
+// Building the function needs every element to have a different hash, so
+// the hasher returns a std::size_t, like std::hash (which is the default),
+// rather than the unsigned int that HashSet's hashers return.  Elements
+// that are equal are only stored once; two different elements with the
+// same hash make the constructor throw a std::invalid_argument.
+//
+// freeze() builds a FrozenSet from a HashSet.  The FrozenSet compares its
+// elements with the HashSet's key equal object, so its hasher has to agree
+// with that object: equal elements must get equal hashes.  std::hash only
+// agrees with std::equal_to, so freezing a HashSet that compares elements
+// some other way (ignoring case, say) needs a hasher to be given for it.
+
+#ifndef FROZENSET_HPP
+#define FROZENSET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <type_traits>
+#include <vector>
+#include "HashSet.hpp"
+#include "Set.hpp"
+
+
+
+template <
+    typename ElementType,
+    typename Hasher = std::hash<ElementType>,
+    typename KeyEqual = std::equal_to<>>
+class FrozenSet : public Set<ElementType>
+{
+public:
+    // The average number of elements in each bucket.  Larger buckets take
+    // less space for the pilots but longer to find pilots for.
+    static constexpr unsigned int BUCKET_SIZE = 4;
+
+public:
+    // Initializes an empty FrozenSet.
+    explicit FrozenSet(const Hasher& hasher = Hasher(), const KeyEqual& keyEqual = KeyEqual());
+
+    // Initializes a FrozenSet containing the elements in the range
+    // [first, last), which can be in any order and can contain duplicates.
+    // Each element is read once and assigned from *first, so a range of
+    // move iterators moves the elements in rather than copying them.
+    template <typename ForwardIterator>
+    FrozenSet(
+        ForwardIterator first, ForwardIterator last,
+        const Hasher& hasher = Hasher(), const KeyEqual& keyEqual = KeyEqual());
+
+    // Cleans up the FrozenSet so that it leaks no memory.
+    ~FrozenSet() noexcept override;
+
+    // Initializes a new FrozenSet to be a copy of an existing one.
+    FrozenSet(const FrozenSet& s);
+
+    // Initializes a new FrozenSet whose contents are moved from an
+    // expiring one.
+    FrozenSet(FrozenSet&& s) noexcept;
+
+    // Assigns an existing FrozenSet into another.
+    FrozenSet& operator=(const FrozenSet& s);
+
+    // Assigns an expiring FrozenSet into another.
+    FrozenSet& operator=(FrozenSet&& s) noexcept;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() always throws a std::logic_error, since a FrozenSet can't be
+    // changed once it's been built.
+    void add(const ElementType& element) override;
+
+
+    // contains() returns true if the given element is in the set, false
+    // otherwise.  This function always runs in constant time: it hashes
+    // the element and makes exactly one comparison.
+    bool contains(const ElementType& element) const override;
+
+
+    // containsKey() is like contains(), but looks for an element equal to
+    // a key of some other type.  The hasher must hash the key exactly as
+    // it would an equal element, and the key equal object must be able to
+    // compare an element with the key.
+    template <typename Key>
+    bool containsKey(const Key& key) const;
+
+
+    // size() returns the number of elements in the set, which is also the
+    // number of slots.
+    unsigned int size() const noexcept override;
+
+
+    // bucketCount() returns the number of buckets, and so of pilots.
+    unsigned int bucketCount() const noexcept;
+
+
+private:
+    Hasher hasher;
+    KeyEqual keyEqual;
+
+    ElementType* slots;
+    unsigned int slotCount;
+    std::uint32_t* pilots;
+    unsigned int buckets;
+
+    static std::uint64_t mix(std::uint64_t hash) noexcept;
+    static unsigned int scale(std::uint64_t hash, unsigned int range) noexcept;
+    static unsigned int slotOf(std::uint64_t mixed, std::uint32_t pilot, unsigned int slotCount) noexcept;
+    void build(ElementType* elements, unsigned int count);
+    void copyFrom(const FrozenSet& s);
+};
+
+
+
+// freeze() returns a FrozenSet holding a copy of every element in the
+// given HashSet, which takes linear time.  The FrozenSet compares the
+// elements with the HashSet's key equal object and hashes them with the
+// given hasher, which must agree with it.  Without a hasher, std::hash is
+// used, which is only allowed when the HashSet uses std::equal_to.
+template <typename ElementType, typename Hasher, typename KeyEqual, typename WideHasher>
+FrozenSet<ElementType, WideHasher, KeyEqual> freeze(
+    const HashSet<ElementType, Hasher, KeyEqual>& set, const WideHasher& hasher);
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FrozenSet<ElementType, std::hash<ElementType>, KeyEqual> freeze(
+    const HashSet<ElementType, Hasher, KeyEqual>& set);
+
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FrozenSet<ElementType, Hasher, KeyEqual>::FrozenSet(const Hasher& hasher, const KeyEqual& keyEqual)
+    : hasher{hasher}, keyEqual{keyEqual}, slots{nullptr}, slotCount{0}, pilots{nullptr}, buckets{0}
+{
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+template <typename ForwardIterator>
+FrozenSet<ElementType, Hasher, KeyEqual>::FrozenSet(
+    ForwardIterator first, ForwardIterator last, const Hasher& hasher, const KeyEqual& keyEqual)
+    : FrozenSet(hasher, keyEqual)
+{
+    unsigned int count = static_cast<unsigned int>(std::distance(first, last));
+    std::unique_ptr<ElementType[]> elements{new ElementType[count]};
+
+    for (unsigned int i = 0; i < count; ++i, ++first)
+    {
+        elements[i] = *first;
+    }
+
+    build(elements.get(), count);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FrozenSet<ElementType, Hasher, KeyEqual>::~FrozenSet() noexcept
+{
+    delete[] slots;
+    delete[] pilots;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FrozenSet<ElementType, Hasher, KeyEqual>::FrozenSet(const FrozenSet& s)
+    : FrozenSet(s.hasher, s.keyEqual)
+{
+    copyFrom(s);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FrozenSet<ElementType, Hasher, KeyEqual>::FrozenSet(FrozenSet&& s) noexcept
+    : FrozenSet(s.hasher, s.keyEqual)
+{
+    std::swap(slots, s.slots);
+    std::swap(slotCount, s.slotCount);
+    std::swap(pilots, s.pilots);
+    std::swap(buckets, s.buckets);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FrozenSet<ElementType, Hasher, KeyEqual>& FrozenSet<ElementType, Hasher, KeyEqual>::operator=(const FrozenSet& s)
+{
+    if (this != &s)
+    {
+        FrozenSet copy{s};
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FrozenSet<ElementType, Hasher, KeyEqual>& FrozenSet<ElementType, Hasher, KeyEqual>::operator=(FrozenSet&& s) noexcept
+{
+    std::swap(hasher, s.hasher);
+    std::swap(keyEqual, s.keyEqual);
+    std::swap(slots, s.slots);
+    std::swap(slotCount, s.slotCount);
+    std::swap(pilots, s.pilots);
+    std::swap(buckets, s.buckets);
+    return *this;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool FrozenSet<ElementType, Hasher, KeyEqual>::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void FrozenSet<ElementType, Hasher, KeyEqual>::add(const ElementType&)
+{
+    throw std::logic_error{"FrozenSet is immutable"};
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool FrozenSet<ElementType, Hasher, KeyEqual>::contains(const ElementType& element) const
+{
+    return containsKey(element);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+template <typename Key>
+bool FrozenSet<ElementType, Hasher, KeyEqual>::containsKey(const Key& key) const
+{
+    if (slotCount == 0)
+    {
+        return false;
+    }
+
+    std::uint64_t mixed = mix(hasher(key));
+    std::uint32_t pilot = pilots[scale(mixed, buckets)];
+    return keyEqual(slots[slotOf(mixed, pilot, slotCount)], key);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+unsigned int FrozenSet<ElementType, Hasher, KeyEqual>::size() const noexcept
+{
+    return slotCount;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+unsigned int FrozenSet<ElementType, Hasher, KeyEqual>::bucketCount() const noexcept
+{
+    return buckets;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+std::uint64_t FrozenSet<ElementType, Hasher, KeyEqual>::mix(std::uint64_t hash) noexcept
+{
+    // The finalizer of MurmurHash3's 64-bit hash, which spreads every bit
+    // of the hash across all of the bits of the result.  Since it can be
+    // undone, different hashes always give different results.
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+unsigned int FrozenSet<ElementType, Hasher, KeyEqual>::scale(std::uint64_t hash, unsigned int range) noexcept
+{
+    // Maps the low half of the hash evenly onto [0, range) without a
+    // division.
+    return static_cast<unsigned int>(((hash & 0xFFFFFFFFull) * range) >> 32);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+unsigned int FrozenSet<ElementType, Hasher, KeyEqual>::slotOf(
+    std::uint64_t mixed, std::uint32_t pilot, unsigned int slotCount) noexcept
+{
+    // The low half of the mixed hash chose the bucket, so the slot comes
+    // from mixing it again with the pilot, which makes the slots of every
+    // element independent of one another for each pilot.
+    return scale(mix(mixed ^ (pilot * 0x9E3779B97F4A7C15ull)), slotCount);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void FrozenSet<ElementType, Hasher, KeyEqual>::build(ElementType* elements, unsigned int count)
+{
+    // Each element's mixed hash is kept alongside its position, sorted by
+    // hash, so that equal elements (and different elements with equal
+    // hashes) end up next to each other.
+    std::vector<std::pair<std::uint64_t, unsigned int>> hashes(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        hashes[i] = {mix(hasher(elements[i])), i};
+    }
+    std::sort(hashes.begin(), hashes.end());
+
+    unsigned int unique = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (unique > 0 && hashes[i].first == hashes[unique - 1].first)
+        {
+            if (!keyEqual(elements[hashes[unique - 1].second], elements[hashes[i].second]))
+            {
+                throw std::invalid_argument{"FrozenSet elements have the same hash"};
+            }
+        }
+        else
+        {
+            hashes[unique++] = hashes[i];
+        }
+    }
+    hashes.resize(unique);
+
+    if (unique == 0)
+    {
+        return;
+    }
+
+    unsigned int newBuckets = (unique + BUCKET_SIZE - 1) / BUCKET_SIZE;
+
+    // The elements are grouped by bucket with a counting sort, and the
+    // buckets are then ordered from the largest to the smallest.
+    std::vector<unsigned int> bucketStart(newBuckets + 1, 0);
+    for (const auto& [hash, element]: hashes)
+    {
+        bucketStart[scale(hash, newBuckets) + 1] += 1;
+    }
+    for (unsigned int b = 0; b < newBuckets; ++b)
+    {
+        bucketStart[b + 1] += bucketStart[b];
+    }
+
+    std::vector<unsigned int> members(unique);
+    std::vector<unsigned int> next{bucketStart.begin(), bucketStart.end() - 1};
+    for (unsigned int i = 0; i < unique; ++i)
+    {
+        members[next[scale(hashes[i].first, newBuckets)]++] = i;
+    }
+
+    std::vector<unsigned int> order(newBuckets);
+    for (unsigned int b = 0; b < newBuckets; ++b)
+    {
+        order[b] = b;
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [&](unsigned int a, unsigned int b)
+        {
+            return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+        });
+
+    // Each bucket tries pilots in turn until one sends all of its elements
+    // to different slots that are still free.  Most buckets find one in a
+    // few tries; only the last few, when the table is nearly full, need
+    // many, and those are the smallest ones.  owners[slot] is the element
+    // given each slot, or unique if it's still free.
+    std::unique_ptr<std::uint32_t[]> newPilots{new std::uint32_t[newBuckets]()};
+    std::vector<unsigned int> owners(unique, unique);
+    std::vector<unsigned int> candidates;
+
+    for (unsigned int b: order)
+    {
+        unsigned int begin = bucketStart[b];
+        unsigned int end = bucketStart[b + 1];
+
+        for (std::uint32_t pilot = 0; begin < end; ++pilot)
+        {
+            candidates.clear();
+            bool fits = true;
+
+            for (unsigned int m = begin; m < end && fits; ++m)
+            {
+                unsigned int slot = slotOf(hashes[members[m]].first, pilot, unique);
+                fits = owners[slot] == unique
+                    && std::find(candidates.begin(), candidates.end(), slot) == candidates.end();
+                candidates.push_back(slot);
+            }
+
+            if (fits)
+            {
+                for (unsigned int m = begin; m < end; ++m)
+                {
+                    owners[candidates[m - begin]] = members[m];
+                }
+                newPilots[b] = pilot;
+                break;
+            }
+        }
+    }
+
+    std::unique_ptr<ElementType[]> newSlots{new ElementType[unique]};
+    for (unsigned int slot = 0; slot < unique; ++slot)
+    {
+        newSlots[slot] = std::move(elements[hashes[owners[slot]].second]);
+    }
+
+    slots = newSlots.release();
+    slotCount = unique;
+    pilots = newPilots.release();
+    buckets = newBuckets;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void FrozenSet<ElementType, Hasher, KeyEqual>::copyFrom(const FrozenSet& s)
+{
+    if (s.slotCount == 0)
+    {
+        return;
+    }
+
+    std::unique_ptr<ElementType[]> newSlots{new ElementType[s.slotCount]};
+    std::copy(s.slots, s.slots + s.slotCount, newSlots.get());
+
+    std::unique_ptr<std::uint32_t[]> newPilots{new std::uint32_t[s.buckets]};
+    std::copy(s.pilots, s.pilots + s.buckets, newPilots.get());
+
+    slots = newSlots.release();
+    slotCount = s.slotCount;
+    pilots = newPilots.release();
+    buckets = s.buckets;
+}
+
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual, typename WideHasher>
+FrozenSet<ElementType, WideHasher, KeyEqual> freeze(
+    const HashSet<ElementType, Hasher, KeyEqual>& set, const WideHasher& hasher)
+{
+    std::vector<ElementType> elements;
+    elements.reserve(set.size());
+
+    set.forEach(
+        [&](const ElementType& element)
+        {
+            elements.push_back(element);
+        });
+
+    return FrozenSet<ElementType, WideHasher, KeyEqual>{
+        std::make_move_iterator(elements.begin()),
+        std::make_move_iterator(elements.end()),
+        hasher,
+        set.getKeyEqual()};
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+FrozenSet<ElementType, std::hash<ElementType>, KeyEqual> freeze(
+    const HashSet<ElementType, Hasher, KeyEqual>& set)
+{
+    static_assert(
+        std::is_same<KeyEqual, std::equal_to<ElementType>>::value
+            || std::is_same<KeyEqual, std::equal_to<>>::value,
+        "freezing a HashSet with its own KeyEqual needs a hasher that agrees with it");
+
+    return freeze(set, std::hash<ElementType>{});
+}
+
+
+#endif
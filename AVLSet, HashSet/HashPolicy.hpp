@@ -0,0 +1,206 @@
+// HashPolicy.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// The hash tables in this project are templated on a "hasher" and a
+// "key equal" type, in the same way as the unordered containers in the
+// C++ Standard Library.  Because the hasher is part of the type, a call
+// to it can be inlined into the table's lookup loop, which isn't possible
+// when the hash function is held in a std::function.
+//
+// A DefaultHasher is the hasher used when none is specified.  Unless it's
+// given a HashFunction, it simply calls std::hash, so a table using it
+// pays nothing to hash an element beyond std::hash itself and a test that
+// it has no HashFunction.  The hash tables' constructors that take a
+// HashFunction give it to their DefaultHasher, which then calls it through
+// a std::function instead, so that those constructors keep working exactly
+// as they always have.  A DefaultHasher<std::string> also hashes a
+// std::string_view exactly as it would an equal std::string, so that one
+// can be looked up with containsKey() without being copied.
+//
+// A StableStringHasher hashes strings with 32-bit FNV-1a.  Unlike
+// std::hash, its results are the same on every platform and in every
+// build, so they can be saved in a file and used by another process.
+//
+// A PolynomialHasher hashes a string by treating its characters as the
+// digits of a number in base BASE (modulo 2^32), then mixing the bits of
+// that "raw" value so that every bit depends on every character.  Since
+// the raw value is a sum of one term per character, the hash of a string
+// that differs from another by a single edit can be found from the other's
+// prefix hashes in constant time, rather than by hashing it all again.
+//
+// A PolynomialHashLookup is a set of strings hashed by a PolynomialHasher
+// that can look a string up by a hash its caller already has, such as a
+// HashSet<std::string, PolynomialHasher> (see HashSet::containsWithHash()).
+// WordChecker::findSuggestions() finds its candidates' hashes from the
+// misspelled word's whenever its Set is one, whatever kind of Set it is.
+// A table whose elements aren't strings, or whose hasher is some other
+// one, derives from the empty NoPolynomialHashLookup instead (see
+// PolynomialHashLookupBase).
+
+#ifndef HASHPOLICY_HPP
+#define HASHPOLICY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+
+template <typename ElementType>
+class DefaultHasher
+{
+public:
+    // A HashFunction is a function that takes a reference to a const
+    // ElementType and returns an unsigned int.
+    using HashFunction = std::function<unsigned int(const ElementType&)>;
+
+public:
+    // Initializes a DefaultHasher that calls std::hash, or the given hash
+    // function if there is one.
+    DefaultHasher() = default;
+
+    explicit DefaultHasher(HashFunction hashFunction)
+        : hashFunction{std::move(hashFunction)}
+    {
+    }
+
+    unsigned int operator()(const ElementType& element) const
+    {
+        if (hashFunction)
+        {
+            return hashFunction(element);
+        }
+
+        return fold(std::hash<ElementType>{}(element));
+    }
+
+    // std::hash<std::string_view> is guaranteed to agree with
+    // std::hash<std::string>, so a view is only copied into a std::string
+    // when it has to be given to a HashFunction.
+    template <
+        typename Key,
+        typename = std::enable_if_t<
+            std::is_same<ElementType, std::string>::value && std::is_same<Key, std::string_view>::value>>
+    unsigned int operator()(Key key) const
+    {
+        if (hashFunction)
+        {
+            return hashFunction(ElementType{key});
+        }
+
+        return fold(std::hash<std::string_view>{}(key));
+    }
+
+private:
+    HashFunction hashFunction;
+
+    // std::hash returns a std::size_t, whose upper half would otherwise be
+    // thrown away, so it's folded into the lower half first.
+    static unsigned int fold(std::size_t hash) noexcept
+    {
+        return static_cast<unsigned int>(hash ^ (hash >> (sizeof(std::size_t) * 4)));
+    }
+};
+
+
+
+class StableStringHasher
+{
+public:
+    unsigned int operator()(std::string_view s) const noexcept
+    {
+        std::uint32_t hash = 2166136261u;
+        for (char c: s)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    unsigned int operator()(const std::string& s) const noexcept
+    {
+        return (*this)(std::string_view{s});
+    }
+};
+
+
+
+class PolynomialHasher
+{
+public:
+    static constexpr std::uint32_t BASE = 2654435761u;
+
+public:
+    unsigned int operator()(std::string_view s) const noexcept
+    {
+        return finish(raw(s));
+    }
+
+    unsigned int operator()(const std::string& s) const noexcept
+    {
+        return (*this)(std::string_view{s});
+    }
+
+    // raw() returns the polynomial value of a string, before it's mixed.
+    static std::uint32_t raw(std::string_view s) noexcept
+    {
+        std::uint32_t value = 0;
+        for (char c: s)
+        {
+            value = value * BASE + static_cast<unsigned char>(c);
+        }
+        return value;
+    }
+
+    // finish() mixes a raw value into the final hash, using the finalizer
+    // from MurmurHash3.
+    static unsigned int finish(std::uint32_t value) noexcept
+    {
+        value ^= value >> 16;
+        value *= 0x85EBCA6Bu;
+        value ^= value >> 13;
+        value *= 0xC2B2AE35u;
+        value ^= value >> 16;
+        return value;
+    }
+};
+
+
+
+class PolynomialHashLookup
+{
+public:
+    virtual ~PolynomialHashLookup() noexcept = default;
+
+
+    // containsWithHash() returns true if the given string is in the set,
+    // false otherwise, given the hash that a PolynomialHasher would return
+    // for it.
+    virtual bool containsWithHash(const std::string& element, unsigned int hash) const = 0;
+};
+
+
+
+class NoPolynomialHashLookup
+{
+};
+
+
+
+// PolynomialHashLookupBase is the base class of a table of ElementType
+// hashed by a Hasher: a PolynomialHashLookup when those are std::string
+// and PolynomialHasher, and a NoPolynomialHashLookup otherwise.
+template <typename ElementType, typename Hasher>
+using PolynomialHashLookupBase = std::conditional_t<
+    std::is_same<ElementType, std::string>::value && std::is_same<Hasher, PolynomialHasher>::value,
+    PolynomialHashLookup, NoPolynomialHashLookup>;
+
+
+#endif
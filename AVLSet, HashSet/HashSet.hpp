@@ -14,36 +14,165 @@
 // elements as there are array cells), the HashSet should be resized so
 // that it is twice as large as it was before.
 //
+// The resizing can be done in one of two ways, chosen in the constructor.
+// By default, every node is relinked into the new array as soon as the
+// resize is triggered.  Alternatively, the resize can be done
+// incrementally: the old array is kept alongside the new one, and each
+// subsequent call to add() moves the nodes from a few of the old array's
+// cells into the new one, so that no single call to add() has to touch
+// every element.  Until the old array has been emptied, contains() looks
+// in both arrays.  Either way, nodes are relinked rather than copied, so
+// a resize allocates only the new array.
+//
+// Elements can also be removed.  When enough have been removed that the
+// size falls below 20% of the capacity, the array is shrunk to about half
+// its size (in the same way it would be grown), so that its memory is
+// given back.
+//
 // You are not permitted to use the containers in the C++ Standard Library
 // (such as std::set, std::map, or std::vector) to store the information
 // in your data structure.  Instead, you'll need to use a dynamically-
 // allocated array and your own linked list implemenation; the linked list
 // doesn't have to be its own class, though you can do that, if you'd like.
+//
+// The hash function and the equality comparison are template parameters
+// (see HashPolicy.hpp), so that both can be inlined.  Every node also
+// stores its element's full hash, which is compared before the elements
+// themselves are, and which is reused whenever the node is moved to a new
+// array, so the hash function is called exactly once per element added.
+// By default, they're a DefaultHasher and std::equal_to<>, which both
+// accept a std::string_view in place of a std::string, so that a
+// HashSet<std::string> can look one up with containsKey() as it is.
+//
+// The nodes are allocated from a NodePool (see NodePool.hpp), so they're
+// packed together in large slabs rather than allocated one at a time.
+//
+// stats() reports how well the elements are spread across the array.  The
+// chain lengths and load factor are always available, since they're found
+// by looking at the array when stats() is called.  The counts of probes
+// per lookup and of resizes are only kept when HASHSET_ENABLE_STATS is
+// defined; otherwise, the code that keeps them isn't compiled at all, and
+// they're reported as zero.
+//
+// Once a HashSet will no longer change, freeze() (see FrozenSet.hpp)
+// makes an immutable FrozenSet holding the same elements, which finds
+// any element with a single probe and no wasted space.
 
 #ifndef HASHSET_HPP
 #define HASHSET_HPP
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
+#include <type_traits>
+#ifdef HASHSET_ENABLE_STATS
+#include <atomic>
+#include <chrono>
+#endif
+#include "HashPolicy.hpp"
+#include "ModificationCounted.hpp"
+#include "NodePool.hpp"
 #include "Set.hpp"
 
 
 
-template <typename ElementType>
-class HashSet : public Set<ElementType>
+// HashSetStats is a snapshot of a HashSet's statistics, as returned by
+// HashSet::stats().  A "probe" is one node examined by a lookup.
+struct HashSetStats
+{
+    // The number of cells whose chains have each length from 0 up to
+    // CHAIN_HISTOGRAM_SIZE - 2; the last entry counts every longer chain.
+    static constexpr unsigned int CHAIN_HISTOGRAM_SIZE = 16;
+
+    unsigned int size;
+    unsigned int capacity;
+    unsigned int occupiedCells;
+    unsigned int longestChain;
+    unsigned int chainLengths[CHAIN_HISTOGRAM_SIZE];
+
+    // These are only counted when HASHSET_ENABLE_STATS is defined.
+    unsigned long long successfulLookups;
+    unsigned long long successfulProbes;
+    unsigned long long maxSuccessfulProbes;
+    unsigned long long unsuccessfulLookups;
+    unsigned long long unsuccessfulProbes;
+    unsigned long long maxUnsuccessfulProbes;
+    unsigned int resizes;
+    double resizeSeconds;
+
+    // loadFactor() is the proportion of size to capacity, while
+    // effectiveLoadFactor() is the average length of the chains that
+    // aren't empty, which is what a lookup actually has to search.  With
+    // a good hash function the two are close; a much larger effective
+    // load factor means the elements are crowding into too few cells.
+    double loadFactor() const noexcept
+    {
+        return capacity == 0 ? 0.0 : static_cast<double>(size) / capacity;
+    }
+
+    double effectiveLoadFactor() const noexcept
+    {
+        return occupiedCells == 0 ? 0.0 : static_cast<double>(size) / occupiedCells;
+    }
+
+    double averageSuccessfulProbes() const noexcept
+    {
+        return successfulLookups == 0 ? 0.0 : static_cast<double>(successfulProbes) / successfulLookups;
+    }
+
+    double averageUnsuccessfulProbes() const noexcept
+    {
+        return unsuccessfulLookups == 0 ? 0.0 : static_cast<double>(unsuccessfulProbes) / unsuccessfulLookups;
+    }
+};
+
+
+
+template <
+    typename ElementType,
+    typename Hasher = DefaultHasher<ElementType>,
+    typename KeyEqual = std::equal_to<>>
+class HashSet
+    : public Set<ElementType>, public ModificationCounted,
+      public PolynomialHashLookupBase<ElementType, Hasher>
 {
 public:
     // The default capacity of the HashSet before anything has been
     // added to it.
     static constexpr unsigned int DEFAULT_CAPACITY = 10;
 
+    // When resizing incrementally, the number of cells of the old array
+    // whose nodes are moved into the new array on each call to add().
+    // Since the new array is more than twice the size of the old one, at
+    // least 0.8 * capacity more elements must be added before the next
+    // resize, so a step of 4 always finishes the move well before then.
+    static constexpr unsigned int MIGRATION_STEP = 4;
+
+    // The proportion of size to capacity below which remove() shrinks the
+    // array.  It's well below half of the 0.8 that triggers growing, so
+    // that adding and removing the same element can't resize each time.
+    static constexpr double SHRINK_LOAD_FACTOR = 0.2;
+
     // A HashFunction is a function that takes a reference to a const
     // ElementType and returns an unsigned int.
     using HashFunction = std::function<unsigned int(const ElementType&)>;
 
 public:
     // Initializes a HashSet to be empty, so that it will use the given
-    // hash function whenever it needs to hash an element.
-    explicit HashSet(HashFunction hashFunction);
+    // hash function whenever it needs to hash an element.  If
+    // shouldResizeIncrementally is true, resizes move the existing nodes
+    // into the new array a few cells at a time rather than all at once.
+    // This requires that a Hasher can be constructed from a HashFunction,
+    // as a DefaultHasher can (see HashPolicy.hpp).
+    explicit HashSet(HashFunction hashFunction, bool shouldResizeIncrementally = false);
+
+    // Initializes a HashSet to be empty, so that it will use the given
+    // hasher and key equal objects whenever it needs to hash or compare
+    // elements.
+    explicit HashSet(
+        const Hasher& hasher = Hasher(),
+        const KeyEqual& keyEqual = KeyEqual(),
+        bool shouldResizeIncrementally = false);
 
     // Cleans up the HashSet so that it leaks no memory.
     ~HashSet() noexcept override;
@@ -74,11 +203,45 @@ public:
     //
     //     capacity * 2 + 1
     //
-    // In the case where the array is resized, this function runs in linear
-    // time (with respect to the number of elements, assuming a good hash
-    // function); otherwise, it runs in constant time (again, assuming a good
-    // hash function).  The amortized running time is also constant.
+    // In the case where the array is resized all at once, this function runs
+    // in linear time (with respect to the number of elements, assuming a good
+    // hash function); otherwise, it runs in constant time (again, assuming a
+    // good hash function).  The amortized running time is also constant.
+    // When resizing incrementally, no call does more than a constant amount
+    // of work beyond allocating the new array.  Given an rvalue, the new
+    // node's element is moved from it rather than copied.
     void add(const ElementType& element) override;
+    void add(ElementType&& element);
+
+
+    // emplace() is like add(), but constructs the element from the given
+    // arguments, directly in a new node.  Since the element has to exist
+    // to be hashed and compared, it's constructed even when an equal one
+    // is already in the set, in which case it's destroyed again.
+    template <typename... Args>
+    void emplace(Args&&... args);
+
+
+    // reserve() makes room for at least count elements, so that adding
+    // elements until there are count of them triggers no resize, and
+    // their nodes all come from one allocation.  If the array has to grow
+    // for that, this resizes it now (all at once or incrementally, as
+    // usual); it never shrinks the array.
+    void reserve(unsigned int count);
+
+
+    // remove() removes an element from the set, unlinking its node and
+    // giving it back to the pool.  If the element isn't in the set, this
+    // function has no effect.  This function triggers a resizing of the
+    // array when the ratio of size to capacity falls below
+    // SHRINK_LOAD_FACTOR (and the capacity is larger than the default), in
+    // which case the new capacity is determined by this formula:
+    //
+    //     (capacity - 1) / 2
+    //
+    // Like add(), it runs in constant time when no resize is triggered, or
+    // when resizing incrementally, and amortized constant time otherwise.
+    void remove(const ElementType& element);
 
 
     // contains() returns true if the given element is already in the set,
@@ -87,10 +250,31 @@ public:
     bool contains(const ElementType& element) const override;
 
 
+    // containsWithHash() is like contains(), but takes the element's hash
+    // rather than computing it, for callers that can compute it more
+    // cheaply themselves.  The hash must be exactly what the hasher would
+    // return for the element.  When the hasher is a PolynomialHasher, this
+    // is also how the HashSet is a PolynomialHashLookup (see HashPolicy.hpp).
+    bool containsWithHash(const ElementType& element, unsigned int hash) const;
+
+
+    // containsKey() is like contains(), but looks for an element equal to
+    // a key of some other type.  The hasher must hash the key exactly as
+    // it would an equal element, and the key equal object must be able to
+    // compare an element with the key.
+    template <typename Key>
+    bool containsKey(const Key& key) const;
+
+
     // size() returns the number of elements in the set.
     unsigned int size() const noexcept override;
 
 
+    // modificationCount() returns the number of elements added and removed
+    // since the set was built (see ModificationCounted.hpp).
+    std::uint64_t modificationCount() const noexcept override;
+
+
     // elementsAtIndex() returns the number of elements that hashed to a
     // particular index in the array.  If the index is out of the boundaries
     // of the array, this function returns 0.
@@ -102,332 +286,791 @@ public:
     // out of the boundaries of the array, this functions returns false.
     bool isElementAtIndex(const ElementType& element, unsigned int index) const;
 
-    unsigned int getCapacity();
+    // getCapacity() returns the size of the array.  While an incremental
+    // resize is underway, this is the size of the new array.
+    unsigned int getCapacity() const noexcept;
+
+
+    // getKeyEqual() returns a copy of the key equal object that the set
+    // compares elements with.
+    KeyEqual getKeyEqual() const;
+
+
+    // forEach() calls the given "visit" function for each element in the
+    // set, in no particular order, which takes linear time.
+    template <typename Visit>
+    void forEach(Visit&& visit) const;
+
+
+    // stats() returns the set's current statistics, which takes linear
+    // time, since every chain is measured.  The counts of lookups and
+    // resizes are since the set was created (a copy starts over) or since
+    // resetStats() was last called.  Lookups made with contains(),
+    // containsWithHash() and containsKey() are counted; they may be made
+    // from several threads at once, so their counts are kept in atomic
+    // variables.
+    HashSetStats stats() const;
+    void resetStats() noexcept;
 
 private:
-    HashFunction hashFunction;
-    
-struct Node
+    Hasher hasher;
+    KeyEqual keyEqual;
+    bool shouldResizeIncrementally;
+
+    struct Node
     {
         ElementType value;
+        unsigned int hash;
         Node *next;
     };
 
+    NodePool<Node> pool;
     unsigned int hashSize;
     unsigned int hashCapacity;
     Node** hashTable;
-    
+
+    // While an incremental resize is underway, oldTable is the array being
+    // emptied and every cell before migratedCells has already been moved;
+    // otherwise, oldTable is nullptr.
+    Node** oldTable;
+    unsigned int oldCapacity;
+    unsigned int migratedCells;
+
+    ModificationCounter modifications;
+
+#ifdef HASHSET_ENABLE_STATS
+    struct Counters
+    {
+        std::atomic<unsigned long long> successfulLookups{0};
+        std::atomic<unsigned long long> successfulProbes{0};
+        std::atomic<unsigned long long> maxSuccessfulProbes{0};
+        std::atomic<unsigned long long> unsuccessfulLookups{0};
+        std::atomic<unsigned long long> unsuccessfulProbes{0};
+        std::atomic<unsigned long long> maxUnsuccessfulProbes{0};
+        unsigned int resizes = 0;
+        double resizeSeconds = 0.0;
+    };
+
+    mutable Counters counters;
+
+    void recordLookup(bool found, unsigned int probes) const noexcept;
+#endif
+
+    static Node** createTable(unsigned int capacity);
+    void destroyTable(Node** table, unsigned int capacity) noexcept;
+    bool find(const ElementType& element, unsigned int hash) const;
+    template <typename Key>
+    bool find(const Key& element, unsigned int hash, unsigned int& probes) const;
+    bool unlink(Node** table, unsigned int index, const ElementType& element, unsigned int hash);
+    void relink(Node* node);
+    void migrate(unsigned int cells);
+    void resize(unsigned int newCapacity);
+    void copyFrom(const HashSet& s);
+
+    template <typename Value>
+    void insert(Value&& element);
 };
 
 
 
-namespace impl_
+// A HashSet constructed from a HashFunction is the usual kind of HashSet,
+// whose DefaultHasher calls the HashFunction.
+template <typename ElementType>
+HashSet(std::function<unsigned int(const ElementType&)>, bool = false)
+    -> HashSet<ElementType>;
+
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+HashSet<ElementType, Hasher, KeyEqual>::HashSet(HashFunction hashFunction, bool shouldResizeIncrementally)
+    : hasher{hashFunction}, keyEqual{}, shouldResizeIncrementally{shouldResizeIncrementally}
 {
-    template <typename ElementType>
-    unsigned int HashSet__undefinedHashFunction(const ElementType& element)
-    {
-        return 0;
-    }
+    static_assert(
+        std::is_constructible<Hasher, HashFunction>::value,
+        "a HashSet given a HashFunction needs a Hasher such as DefaultHasher<ElementType>");
+
+    hashCapacity = DEFAULT_CAPACITY;
+    hashSize = 0;
+    hashTable = createTable(hashCapacity);
+    oldTable = nullptr;
+    oldCapacity = 0;
+    migratedCells = 0;
 }
 
 
-template <typename ElementType>
-HashSet<ElementType>::HashSet(HashFunction hashFunction)
-    : hashFunction{hashFunction}
+template <typename ElementType, typename Hasher, typename KeyEqual>
+HashSet<ElementType, Hasher, KeyEqual>::HashSet(
+    const Hasher& hasher, const KeyEqual& keyEqual, bool shouldResizeIncrementally)
+    : hasher{hasher}, keyEqual{keyEqual}, shouldResizeIncrementally{shouldResizeIncrementally}
 {
     hashCapacity = DEFAULT_CAPACITY;
     hashSize = 0;
-    hashTable = new Node* [hashCapacity];
-    for (int i=0;i<hashCapacity;++i)
+    hashTable = createTable(hashCapacity);
+    oldTable = nullptr;
+    oldCapacity = 0;
+    migratedCells = 0;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+HashSet<ElementType, Hasher, KeyEqual>::~HashSet() noexcept
+{
+    destroyTable(hashTable, hashCapacity);
+    destroyTable(oldTable, oldCapacity);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+HashSet<ElementType, Hasher, KeyEqual>::HashSet(const HashSet& s)
+    : hasher{s.hasher}, keyEqual{s.keyEqual}, shouldResizeIncrementally{s.shouldResizeIncrementally}
+{
+    copyFrom(s);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+HashSet<ElementType, Hasher, KeyEqual>::HashSet(HashSet&& s) noexcept
+    : hasher{s.hasher}, keyEqual{s.keyEqual}, shouldResizeIncrementally{s.shouldResizeIncrementally}
+{
+    hashSize = 0;
+    hashCapacity = DEFAULT_CAPACITY;
+    hashTable = createTable(hashCapacity);
+    oldTable = nullptr;
+    oldCapacity = 0;
+    migratedCells = 0;
+
+    pool.swap(s.pool);
+    std::swap(hashCapacity, s.hashCapacity);
+    std::swap(hashSize, s.hashSize);
+    std::swap(hashTable, s.hashTable);
+    std::swap(oldTable, s.oldTable);
+    std::swap(oldCapacity, s.oldCapacity);
+    std::swap(migratedCells, s.migratedCells);
+    s.modifications.bump();
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+HashSet<ElementType, Hasher, KeyEqual>& HashSet<ElementType, Hasher, KeyEqual>::operator=(const HashSet& s)
+{
+    if (this != &s)
     {
-        hashTable[i] = nullptr;
+        destroyTable(hashTable, hashCapacity);
+        destroyTable(oldTable, oldCapacity);
+        pool.release();
+
+        hasher = s.hasher;
+        keyEqual = s.keyEqual;
+        shouldResizeIncrementally = s.shouldResizeIncrementally;
+        copyFrom(s);
+        modifications.bump();
     }
+
+    return *this;
 }
 
 
-template <typename ElementType>
-HashSet<ElementType>::~HashSet() noexcept
+template <typename ElementType, typename Hasher, typename KeyEqual>
+HashSet<ElementType, Hasher, KeyEqual>& HashSet<ElementType, Hasher, KeyEqual>::operator=(HashSet&& s) noexcept
+{
+    std::swap(hasher, s.hasher);
+    std::swap(keyEqual, s.keyEqual);
+    std::swap(shouldResizeIncrementally, s.shouldResizeIncrementally);
+    pool.swap(s.pool);
+    std::swap(hashSize, s.hashSize);
+    std::swap(hashCapacity, s.hashCapacity);
+    std::swap(hashTable, s.hashTable);
+    std::swap(oldTable, s.oldTable);
+    std::swap(oldCapacity, s.oldCapacity);
+    std::swap(migratedCells, s.migratedCells);
+    modifications.bump();
+    s.modifications.bump();
+    return *this;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool HashSet<ElementType, Hasher, KeyEqual>::isImplemented() const noexcept
 {
-    for (unsigned int i=0;i<hashCapacity;i++)
+    return true;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void HashSet<ElementType, Hasher, KeyEqual>::add(const ElementType& element)
+{
+    insert(element);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void HashSet<ElementType, Hasher, KeyEqual>::add(ElementType&& element)
+{
+    insert(std::move(element));
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+template <typename... Args>
+void HashSet<ElementType, Hasher, KeyEqual>::emplace(Args&&... args)
+{
+    if (oldTable != nullptr)
+    {
+        migrate(MIGRATION_STEP);
+    }
+
+    Node* node = pool.create(InPlace<ElementType, Args...>{std::forward<Args>(args)...}, 0u, nullptr);
+
+    try
     {
-        Node* current = hashTable[i];
-        while(current != nullptr)
+        node->hash = hasher(node->value);
+
+        if (find(node->value, node->hash))
         {
-            Node* entry = current;
-            current = current->next;
-            delete entry;
+            pool.destroy(node);
+            return;
+        }
+
+        if (hashSize > 0.8 * hashCapacity)
+        {
+            resize(hashCapacity * 2 + 1);
         }
     }
-    delete[] hashTable;
+    catch (...)
+    {
+        pool.destroy(node);
+        throw;
+    }
+
+    unsigned int index = node->hash % hashCapacity;
+    node->next = hashTable[index];
+    hashTable[index] = node;
+    hashSize += 1;
+    modifications.bump();
 }
 
 
-template <typename ElementType>
-HashSet<ElementType>::HashSet(const HashSet& s)
-    : hashFunction{impl_::HashSet__undefinedHashFunction<ElementType>}
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void HashSet<ElementType, Hasher, KeyEqual>::reserve(unsigned int count)
 {
-    hashSize = s.hashSize;
-    hashCapacity = s.hashCapacity;
-    hashTable = new Node*[hashCapacity];
-    for (int i=0;i<hashCapacity;++i)
+    // add() grows the array once the size is more than 0.8 times the
+    // capacity, so count elements fit in a capacity of count / 0.8.
+    unsigned int capacity = static_cast<unsigned int>(std::ceil(count / 0.8));
+
+    if (capacity > hashCapacity)
+    {
+        resize(capacity);
+    }
+
+    if (count > hashSize)
+    {
+        pool.reserve(count - hashSize);
+    }
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void HashSet<ElementType, Hasher, KeyEqual>::remove(const ElementType& element)
+{
+    if (oldTable != nullptr)
+    {
+        migrate(MIGRATION_STEP);
+    }
+
+    unsigned int hash = hasher(element);
+    bool removed = unlink(hashTable, hash % hashCapacity, element, hash);
+
+    if (!removed && oldTable != nullptr && hash % oldCapacity >= migratedCells)
+    {
+        removed = unlink(oldTable, hash % oldCapacity, element, hash);
+    }
+
+    if (!removed)
+    {
+        return;
+    }
+
+    hashSize -= 1;
+    modifications.bump();
+
+    if (hashCapacity > DEFAULT_CAPACITY && hashSize < SHRINK_LOAD_FACTOR * hashCapacity)
+    {
+        resize(std::max((hashCapacity - 1) / 2, DEFAULT_CAPACITY));
+    }
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool HashSet<ElementType, Hasher, KeyEqual>::contains(const ElementType& element) const
+{
+    // The call is qualified so that it's never made through the
+    // PolynomialHashLookup's virtual function.
+    return HashSet::containsWithHash(element, hasher(element));
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool HashSet<ElementType, Hasher, KeyEqual>::containsWithHash(const ElementType& element, unsigned int hash) const
+{
+    unsigned int probes = 0;
+    bool found = find(element, hash, probes);
+
+#ifdef HASHSET_ENABLE_STATS
+    recordLookup(found, probes);
+#endif
+
+    return found;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+template <typename Key>
+bool HashSet<ElementType, Hasher, KeyEqual>::containsKey(const Key& key) const
+{
+    unsigned int probes = 0;
+    bool found = find(key, hasher(key), probes);
+
+#ifdef HASHSET_ENABLE_STATS
+    recordLookup(found, probes);
+#endif
+
+    return found;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+unsigned int HashSet<ElementType, Hasher, KeyEqual>::size() const noexcept
+{
+    return hashSize;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+std::uint64_t HashSet<ElementType, Hasher, KeyEqual>::modificationCount() const noexcept
+{
+    return modifications.value();
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+unsigned int HashSet<ElementType, Hasher, KeyEqual>::elementsAtIndex(unsigned int index) const
+{
+    unsigned int counter = 0;
+    if (index>=hashCapacity)
+    {
+        return 0;
+    }
+    else
     {
-        hashTable[i] = nullptr;
+        Node* find = hashTable[index];
+        while(find != nullptr)
+        {
+            counter += 1;
+            find = find->next;
+        }
 
-        Node* oldPointer = s.hashTable[i];
-        while (oldPointer != nullptr)
+        // Nodes that haven't been moved out of the old array yet still
+        // belong to their cell in the new one.
+        if (oldTable != nullptr)
         {
-            Node* newNode = new Node();
-            newNode->next = nullptr;
-            newNode->value = oldPointer->value;
-            if (hashTable[i]==nullptr)
-            {
-                hashTable[i] = newNode;
-            } 
-            else
+            for (unsigned int i = migratedCells; i < oldCapacity; ++i)
             {
-                Node* find = hashTable[i];
-                while (find->next != nullptr)
+                for (Node* old = oldTable[i]; old != nullptr; old = old->next)
                 {
-                    find = find->next;
+                    if (old->hash % hashCapacity == index)
+                    {
+                        counter += 1;
+                    }
                 }
-                find->next = newNode;
             }
-            oldPointer = oldPointer->next;
         }
+
+        return counter;
     }
 }
 
 
-template <typename ElementType>
-HashSet<ElementType>::HashSet(HashSet&& s) noexcept
-    : hashFunction{impl_::HashSet__undefinedHashFunction<ElementType>}
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool HashSet<ElementType, Hasher, KeyEqual>::isElementAtIndex(const ElementType& element, unsigned int index) const
 {
-    hashSize = 0;
-    hashCapacity = DEFAULT_CAPACITY;
-    hashTable = new Node*[hashCapacity];
+    if (index>=hashCapacity)
+    { 
+        return false;
+    }
+    else
+    {
+        unsigned int hash = hasher(element);
+        return hash % hashCapacity == index && find(element, hash);
+    }
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+unsigned int HashSet<ElementType, Hasher, KeyEqual>::getCapacity() const noexcept
+{
+    return hashCapacity;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+KeyEqual HashSet<ElementType, Hasher, KeyEqual>::getKeyEqual() const
+{
+    return keyEqual;
+}
+
 
-    for (unsigned int index=0;index<hashCapacity;index++)
+template <typename ElementType, typename Hasher, typename KeyEqual>
+template <typename Visit>
+void HashSet<ElementType, Hasher, KeyEqual>::forEach(Visit&& visit) const
+{
+    // Nodes that haven't been moved out of the old array yet are elements
+    // too.
+    for (unsigned int i = 0; i < hashCapacity; ++i)
     {
-        hashTable[index] = nullptr;
+        for (Node* node = hashTable[i]; node != nullptr; node = node->next)
+        {
+            visit(static_cast<const ElementType&>(node->value));
+        }
     }
 
-    std::swap(hashCapacity, s.hashCapacity);
-    std::swap(hashSize, s.hashSize);
-    std::swap(hashTable,s.hashTable);
+    for (unsigned int i = migratedCells; oldTable != nullptr && i < oldCapacity; ++i)
+    {
+        for (Node* node = oldTable[i]; node != nullptr; node = node->next)
+        {
+            visit(static_cast<const ElementType&>(node->value));
+        }
+    }
 }
 
 
-template <typename ElementType>
-HashSet<ElementType>& HashSet<ElementType>::operator=(const HashSet& s)
+template <typename ElementType, typename Hasher, typename KeyEqual>
+HashSetStats HashSet<ElementType, Hasher, KeyEqual>::stats() const
 {
-    delete[] hashTable;
+    HashSetStats stats{};
+    stats.size = hashSize;
+    stats.capacity = hashCapacity;
 
-    hashSize = s.hashSize;
-    hashCapacity = s.hashCapacity;
-    hashTable = new Node*[hashCapacity];
+    // While a resize is underway, the nodes still in the old array are
+    // counted in the cells of the new array that they'll be moved to.
+    unsigned int* lengths = new unsigned int[hashCapacity];
 
-    for (int i=0;i<hashCapacity;++i)
+    for (unsigned int i = 0; i < hashCapacity; ++i)
     {
-        hashTable[i] = nullptr;
+        lengths[i] = 0;
+        for (Node* node = hashTable[i]; node != nullptr; node = node->next)
+        {
+            lengths[i] += 1;
+        }
+    }
 
-        Node* oldPointer = s.hashTable[i];
-        while (oldPointer != nullptr)
+    for (unsigned int i = migratedCells; oldTable != nullptr && i < oldCapacity; ++i)
+    {
+        for (Node* node = oldTable[i]; node != nullptr; node = node->next)
         {
-            Node* newNode = new Node();
-            newNode->next = nullptr;
-            newNode->value = oldPointer->value;
-            if (hashTable[i]==nullptr)
-            {
-                hashTable[i] = newNode;
-            } 
-            else
-            {
-                Node* find = hashTable[i];
-                while (find->next != nullptr)
-                {
-                    find = find->next;
-                }
-                find->next = newNode;
-            }
-            oldPointer = oldPointer->next;
+            lengths[node->hash % hashCapacity] += 1;
         }
     }
 
-    return *this;
+    for (unsigned int i = 0; i < hashCapacity; ++i)
+    {
+        stats.chainLengths[std::min(lengths[i], HashSetStats::CHAIN_HISTOGRAM_SIZE - 1)] += 1;
+        stats.longestChain = std::max(stats.longestChain, lengths[i]);
+        if (lengths[i] > 0)
+        {
+            stats.occupiedCells += 1;
+        }
+    }
+
+    delete[] lengths;
+
+#ifdef HASHSET_ENABLE_STATS
+    stats.successfulLookups = counters.successfulLookups.load(std::memory_order_relaxed);
+    stats.successfulProbes = counters.successfulProbes.load(std::memory_order_relaxed);
+    stats.maxSuccessfulProbes = counters.maxSuccessfulProbes.load(std::memory_order_relaxed);
+    stats.unsuccessfulLookups = counters.unsuccessfulLookups.load(std::memory_order_relaxed);
+    stats.unsuccessfulProbes = counters.unsuccessfulProbes.load(std::memory_order_relaxed);
+    stats.maxUnsuccessfulProbes = counters.maxUnsuccessfulProbes.load(std::memory_order_relaxed);
+    stats.resizes = counters.resizes;
+    stats.resizeSeconds = counters.resizeSeconds;
+#endif
+
+    return stats;
 }
 
 
-template <typename ElementType>
-HashSet<ElementType>& HashSet<ElementType>::operator=(HashSet&& s) noexcept
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void HashSet<ElementType, Hasher, KeyEqual>::resetStats() noexcept
 {
-    std::swap(hashSize, s.hashSize);
-    std::swap(hashCapacity, s.hashCapacity);
-    std::swap(hashTable, s.hashTable);
-    return *this;
+#ifdef HASHSET_ENABLE_STATS
+    counters.successfulLookups.store(0, std::memory_order_relaxed);
+    counters.successfulProbes.store(0, std::memory_order_relaxed);
+    counters.maxSuccessfulProbes.store(0, std::memory_order_relaxed);
+    counters.unsuccessfulLookups.store(0, std::memory_order_relaxed);
+    counters.unsuccessfulProbes.store(0, std::memory_order_relaxed);
+    counters.maxUnsuccessfulProbes.store(0, std::memory_order_relaxed);
+    counters.resizes = 0;
+    counters.resizeSeconds = 0.0;
+#endif
 }
 
 
-template <typename ElementType>
-bool HashSet<ElementType>::isImplemented() const noexcept
+#ifdef HASHSET_ENABLE_STATS
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void HashSet<ElementType, Hasher, KeyEqual>::recordLookup(bool found, unsigned int probes) const noexcept
 {
-    return true;
+    std::atomic<unsigned long long>& lookups = found ? counters.successfulLookups : counters.unsuccessfulLookups;
+    std::atomic<unsigned long long>& total = found ? counters.successfulProbes : counters.unsuccessfulProbes;
+    std::atomic<unsigned long long>& max = found ? counters.maxSuccessfulProbes : counters.maxUnsuccessfulProbes;
+
+    lookups.fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(probes, std::memory_order_relaxed);
+
+    unsigned long long previous = max.load(std::memory_order_relaxed);
+    while (probes > previous && !max.compare_exchange_weak(previous, probes, std::memory_order_relaxed))
+    {
+    }
 }
+#endif
 
 
-template <typename ElementType>
-void HashSet<ElementType>::add(const ElementType& element)
+template <typename ElementType, typename Hasher, typename KeyEqual>
+typename HashSet<ElementType, Hasher, KeyEqual>::Node** HashSet<ElementType, Hasher, KeyEqual>::createTable(unsigned int capacity)
 {
-    if (contains(element)==false)
+    Node** table = new Node*[capacity];
+    for (unsigned int i=0;i<capacity;++i)
     {
-        if (hashSize > 0.8*hashCapacity)
+        table[i] = nullptr;
+    }
+    return table;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void HashSet<ElementType, Hasher, KeyEqual>::destroyTable(Node** table, unsigned int capacity) noexcept
+{
+    // The nodes' space is given back all at once when the pool is
+    // released, so only their destructors need to be run here, and not
+    // even those if there's nothing for them to do.
+    if (table == nullptr)
+    {
+        return;
+    }
+
+    if constexpr (!std::is_trivially_destructible<Node>::value)
+    {
+        for (unsigned int i=0;i<capacity;i++)
         {
-            unsigned int newCapacity = hashCapacity * 2 + 1;
-            Node** newHashTable = new Node*[newCapacity];
-            for (unsigned int i=0;i<newCapacity;++i)
+            Node* current = table[i];
+            while(current != nullptr)
             {
-                newHashTable[i] = nullptr;
+                Node* entry = current;
+                current = current->next;
+                entry->~Node();
             }
-            for (int i=0;i<hashCapacity;++i)
-            {
-                Node* oldPointer = hashTable[i];
-                while (oldPointer != nullptr)
-                {
-                    Node* newNode = new Node();
-                    newNode->next = nullptr;
-                    newNode->value = oldPointer->value;
-                    if (newHashTable[i]==nullptr)
-                    {
-                        newHashTable[i] = newNode;
-                    } 
-                    else
-                    {
-                        Node* find = newHashTable[i];
-                        while (find->next != nullptr)
-                        {
-                            find = find->next;
-                        }
-                        find->next = newNode;
-                    }
-                    oldPointer = oldPointer->next;
-                }
-            }
-            hashTable = newHashTable;
-            hashCapacity = newCapacity;
-            unsigned int cell = hashFunction(element) % hashCapacity;
-            hashSize += 1;
-            Node* add = new Node();
-            add->next = nullptr;
-            add->value = element;
-            if (hashTable[cell]==nullptr)
-            {
-                hashTable[cell] = add;
-            }
-            else
-            {
-                Node* addNode = hashTable[cell];
-                while(addNode->next != nullptr)
-                {
-                    addNode = addNode->next;
-                }
-                addNode->next = add;
-            }            
         }
-        else 
+    }
+    delete[] table;
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool HashSet<ElementType, Hasher, KeyEqual>::find(const ElementType& element, unsigned int hash) const
+{
+    unsigned int probes = 0;
+    return find(element, hash, probes);
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+template <typename Key>
+bool HashSet<ElementType, Hasher, KeyEqual>::find(
+    const Key& element, unsigned int hash, unsigned int& probes) const
+{
+    // When nobody reads the number of probes, the compiler drops the code
+    // that counts them.
+    for (Node* find = hashTable[hash % hashCapacity]; find != nullptr; find = find->next)
+    {
+        probes += 1;
+        if (find->hash == hash && keyEqual(find->value, element))
+        {
+            return true;
+        }
+    }
+
+    if (oldTable != nullptr)
+    {
+        unsigned int index = hash % oldCapacity;
+        if (index >= migratedCells)
         {
-            unsigned int index = hashFunction(element) % hashCapacity;
-            hashSize += 1;
-            Node* add = new Node();
-            add->next = nullptr;
-            add->value = element;
-            if (hashTable[index]==nullptr)
-            {
-                hashTable[index] = add;
-            }
-            else
+            for (Node* find = oldTable[index]; find != nullptr; find = find->next)
             {
-                Node* addNode = hashTable[index];
-                while(addNode->next != nullptr)
+                probes += 1;
+                if (find->hash == hash && keyEqual(find->value, element))
                 {
-                    addNode = addNode->next;
+                    return true;
                 }
-                addNode->next = add;
             }
         }
     }
+
+    return false;
 }
 
 
-template <typename ElementType>
-bool HashSet<ElementType>::contains(const ElementType& element) const
+template <typename ElementType, typename Hasher, typename KeyEqual>
+bool HashSet<ElementType, Hasher, KeyEqual>::unlink(
+    Node** table, unsigned int index, const ElementType& element, unsigned int hash)
 {
-    unsigned int index = hashFunction(element) % hashCapacity;
-    Node* find = hashTable[index];
-    while (find != nullptr)
+    // link is the pointer that points to the current node, whether that's
+    // the cell itself or the previous node's next pointer, so the node can
+    // be unlinked the same way wherever it is in the chain.
+    for (Node** link = &table[index]; *link != nullptr; link = &(*link)->next)
     {
-        if (find->value==element)
+        Node* node = *link;
+        if (node->hash == hash && keyEqual(node->value, element))
         {
+            *link = node->next;
+            pool.destroy(node);
             return true;
         }
-        find = find->next;
     }
+
     return false;
 }
 
 
-template <typename ElementType>
-unsigned int HashSet<ElementType>::size() const noexcept
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void HashSet<ElementType, Hasher, KeyEqual>::relink(Node* node)
 {
-    return hashSize;
+    unsigned int index = node->hash % hashCapacity;
+    node->next = hashTable[index];
+    hashTable[index] = node;
 }
 
 
-template <typename ElementType>
-unsigned int HashSet<ElementType>::elementsAtIndex(unsigned int index) const
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void HashSet<ElementType, Hasher, KeyEqual>::migrate(unsigned int cells)
 {
-    unsigned int counter = 0;
-    if (index>=hashCapacity)
-    {
-        return 0;
-    }
-    else
+#ifdef HASHSET_ENABLE_STATS
+    auto start = std::chrono::steady_clock::now();
+#endif
+
+    for (; cells > 0 && migratedCells < oldCapacity; --cells, ++migratedCells)
     {
-        Node* find = hashTable[index];
-        while(find != nullptr)
+        Node* current = oldTable[migratedCells];
+        oldTable[migratedCells] = nullptr;
+
+        while (current != nullptr)
         {
-            counter += 1;
-            find = find->next;
+            Node* next = current->next;
+            relink(current);
+            current = next;
         }
-        return counter;
     }
+
+    if (migratedCells == oldCapacity)
+    {
+        delete[] oldTable;
+        oldTable = nullptr;
+        oldCapacity = 0;
+        migratedCells = 0;
+    }
+
+#ifdef HASHSET_ENABLE_STATS
+    counters.resizeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+#endif
 }
 
 
-template <typename ElementType>
-bool HashSet<ElementType>::isElementAtIndex(const ElementType& element, unsigned int index) const
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void HashSet<ElementType, Hasher, KeyEqual>::resize(unsigned int newCapacity)
 {
-    if (index>=hashCapacity)
-    { 
-        return false;
+    // A resize can't start while another is still underway, since a
+    // lookup only knows how to look in two arrays.
+    if (oldTable != nullptr)
+    {
+        migrate(oldCapacity);
     }
-    else
+
+#ifdef HASHSET_ENABLE_STATS
+    auto start = std::chrono::steady_clock::now();
+#endif
+
+    Node** newTable = createTable(newCapacity);
+    oldTable = hashTable;
+    oldCapacity = hashCapacity;
+    migratedCells = 0;
+    hashTable = newTable;
+    hashCapacity = newCapacity;
+
+#ifdef HASHSET_ENABLE_STATS
+    counters.resizes += 1;
+    counters.resizeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+#endif
+
+    if (!shouldResizeIncrementally)
     {
-        Node* find = hashTable[index];
-        while (find != nullptr)
+        migrate(oldCapacity);
+    }
+}
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+void HashSet<ElementType, Hasher, KeyEqual>::copyFrom(const HashSet& s)
+{
+    // The copy is made in one step, so it never inherits an unfinished
+    // resize from s.
+    hashSize = s.hashSize;
+    hashCapacity = s.hashCapacity;
+    hashTable = createTable(hashCapacity);
+    oldTable = nullptr;
+    oldCapacity = 0;
+    migratedCells = 0;
+    pool.reserve(hashSize);
+
+    for (unsigned int i=0;i<s.hashCapacity;++i)
+    {
+        for (Node* oldPointer = s.hashTable[i]; oldPointer != nullptr; oldPointer = oldPointer->next)
         {
-            if (find->value == element)
-            {
-                return true;
-            }
-            find = find->next;
+            hashTable[i] = pool.create(oldPointer->value, oldPointer->hash, hashTable[i]);
+        }
+    }
+
+    for (unsigned int i=s.migratedCells;i<s.oldCapacity;++i)
+    {
+        for (Node* oldPointer = s.oldTable[i]; oldPointer != nullptr; oldPointer = oldPointer->next)
+        {
+            relink(pool.create(oldPointer->value, oldPointer->hash, nullptr));
         }
     }
-    return false;
 }
-template <typename ElementType>
-unsigned int HashSet<ElementType>::getCapacity()
+
+
+template <typename ElementType, typename Hasher, typename KeyEqual>
+template <typename Value>
+void HashSet<ElementType, Hasher, KeyEqual>::insert(Value&& element)
 {
-    
-    return this->hashCapacity;
+    if (oldTable != nullptr)
+    {
+        migrate(MIGRATION_STEP);
+    }
+
+    unsigned int hash = hasher(element);
+
+    if (find(element, hash))
+    {
+        return;
+    }
+
+    if (hashSize > 0.8 * hashCapacity)
+    {
+        resize(hashCapacity * 2 + 1);
+    }
+
+    unsigned int index = hash % hashCapacity;
+    hashTable[index] = pool.create(std::forward<Value>(element), hash, hashTable[index]);
+    hashSize += 1;
+    modifications.bump();
 }
 
 #endif
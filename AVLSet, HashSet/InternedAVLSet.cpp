@@ -0,0 +1,78 @@
+// InternedAVLSet.cpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Implementation of the InternedAVLSet class.
+
+#include "InternedAVLSet.hpp"
+#include <utility>
+
+
+InternedAVLSet::InternedAVLSet()
+    : arena{std::make_unique<StringArena>()},
+      handles{ArenaLess{arena.get()}}
+{
+}
+
+
+InternedAVLSet::~InternedAVLSet() noexcept = default;
+
+
+InternedAVLSet::InternedAVLSet(InternedAVLSet&& s) noexcept
+    : arena{std::move(s.arena)}, handles{std::move(s.handles)}
+{
+}
+
+
+InternedAVLSet& InternedAVLSet::operator=(InternedAVLSet&& s) noexcept
+{
+    std::swap(arena, s.arena);
+    std::swap(handles, s.handles);
+    return *this;
+}
+
+
+bool InternedAVLSet::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+void InternedAVLSet::add(const std::string& element)
+{
+    if (!handles.containsKey(std::string_view{element}))
+    {
+        handles.add(arena->append(element));
+    }
+}
+
+
+bool InternedAVLSet::contains(const std::string& element) const
+{
+    return containsKey(element);
+}
+
+
+bool InternedAVLSet::containsKey(std::string_view element) const
+{
+    return handles.containsKey(element);
+}
+
+
+unsigned int InternedAVLSet::size() const noexcept
+{
+    return handles.size();
+}
+
+
+std::uint64_t InternedAVLSet::modificationCount() const noexcept
+{
+    return handles.modificationCount();
+}
+
+
+const StringArena& InternedAVLSet::strings() const noexcept
+{
+    return *arena;
+}
@@ -0,0 +1,101 @@
+// InternedAVLSet.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// An InternedAVLSet is a Set of words that keeps the characters of every
+// word in a StringArena (see StringArena.hpp), and only their handles in
+// an AVLSet ordered by ArenaLess.  Each node of the AVLSet is then 40
+// bytes rather than 64, and no word, however long, takes an allocation of
+// its own, which makes it much smaller than an AVLSet<std::string>
+// holding the same words.  Each comparison on the way down the tree has
+// to find the word's characters in the arena, where an AVLSet of short
+// std::strings would find them in the node itself.
+//
+// An InternedAVLSet can't be copied, since its AVLSet refers to its
+// arena; it can be moved, but a set that has been moved from can only be
+// destroyed or assigned to.
+
+#ifndef INTERNEDAVLSET_HPP
+#define INTERNEDAVLSET_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include "AVLSet.hpp"
+#include "ModificationCounted.hpp"
+#include "Set.hpp"
+#include "StringArena.hpp"
+
+
+
+class InternedAVLSet : public Set<std::string>, public ModificationCounted
+{
+public:
+    // Initializes an empty InternedAVLSet.
+    InternedAVLSet();
+
+    ~InternedAVLSet() noexcept override;
+
+    InternedAVLSet(const InternedAVLSet& s) = delete;
+    InternedAVLSet& operator=(const InternedAVLSet& s) = delete;
+    InternedAVLSet(InternedAVLSet&& s) noexcept;
+    InternedAVLSet& operator=(InternedAVLSet&& s) noexcept;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() adds a word to the set, copying its characters into the arena
+    // only if it isn't already there.
+    void add(const std::string& element) override;
+
+
+    // contains() returns true if the given word is in the set, false
+    // otherwise.  containsKey() does the same for a std::string_view.
+    bool contains(const std::string& element) const override;
+    bool containsKey(std::string_view element) const;
+
+
+    // size() returns the number of words in the set.
+    unsigned int size() const noexcept override;
+
+
+    // modificationCount() returns the number of words added since the set
+    // was built (see ModificationCounted.hpp).
+    std::uint64_t modificationCount() const noexcept override;
+
+
+    // strings() returns the arena holding the words' characters.
+    const StringArena& strings() const noexcept;
+
+
+    // forEachInorder() calls the given "visit" function with each of the
+    // words in the set, as a std::string_view, in ascending order.
+    template <typename Visit>
+    void forEachInorder(Visit&& visit) const;
+
+
+private:
+    // The arena is allocated separately, so that it stays where the
+    // AVLSet's Compare object expects it when the set is moved.
+    std::unique_ptr<StringArena> arena;
+    AVLSet<StringHandle, ArenaLess> handles;
+};
+
+
+
+template <typename Visit>
+void InternedAVLSet::forEachInorder(Visit&& visit) const
+{
+    const StringArena& words = *arena;
+    handles.forEachInorder(
+        [&](StringHandle handle)
+        {
+            visit(words.view(handle));
+        });
+}
+
+
+
+#endif
@@ -0,0 +1,78 @@
+// InternedHashSet.cpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Implementation of the InternedHashSet class.
+
+#include "InternedHashSet.hpp"
+#include <utility>
+
+
+InternedHashSet::InternedHashSet()
+    : arena{std::make_unique<StringArena>()},
+      handles{ArenaHasher{arena.get()}, ArenaEqual{arena.get()}}
+{
+}
+
+
+InternedHashSet::~InternedHashSet() noexcept = default;
+
+
+InternedHashSet::InternedHashSet(InternedHashSet&& s) noexcept
+    : arena{std::move(s.arena)}, handles{std::move(s.handles)}
+{
+}
+
+
+InternedHashSet& InternedHashSet::operator=(InternedHashSet&& s) noexcept
+{
+    std::swap(arena, s.arena);
+    std::swap(handles, s.handles);
+    return *this;
+}
+
+
+bool InternedHashSet::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+void InternedHashSet::add(const std::string& element)
+{
+    if (!handles.containsKey(std::string_view{element}))
+    {
+        handles.add(arena->append(element));
+    }
+}
+
+
+bool InternedHashSet::contains(const std::string& element) const
+{
+    return containsKey(element);
+}
+
+
+bool InternedHashSet::containsKey(std::string_view element) const
+{
+    return handles.containsKey(element);
+}
+
+
+unsigned int InternedHashSet::size() const noexcept
+{
+    return handles.size();
+}
+
+
+std::uint64_t InternedHashSet::modificationCount() const noexcept
+{
+    return handles.modificationCount();
+}
+
+
+const StringArena& InternedHashSet::strings() const noexcept
+{
+    return *arena;
+}
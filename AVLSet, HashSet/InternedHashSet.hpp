@@ -0,0 +1,81 @@
+// InternedHashSet.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// An InternedHashSet is a Set of words that keeps the characters of every
+// word in a StringArena (see StringArena.hpp), and only their handles in
+// a HashSet.  Each node of the HashSet is then 24 bytes rather than 48,
+// and no word, however long, takes an allocation of its own, which makes
+// it much smaller than a HashSet<std::string> holding the same words.
+// Lookups are as fast, since a word's hash is stored in its node and is
+// compared before its characters are.
+//
+// An InternedHashSet can't be copied, since its HashSet refers to its
+// arena; it can be moved, but a set that has been moved from can only be
+// destroyed or assigned to.
+
+#ifndef INTERNEDHASHSET_HPP
+#define INTERNEDHASHSET_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include "HashSet.hpp"
+#include "ModificationCounted.hpp"
+#include "Set.hpp"
+#include "StringArena.hpp"
+
+
+
+class InternedHashSet : public Set<std::string>, public ModificationCounted
+{
+public:
+    // Initializes an empty InternedHashSet.
+    InternedHashSet();
+
+    ~InternedHashSet() noexcept override;
+
+    InternedHashSet(const InternedHashSet& s) = delete;
+    InternedHashSet& operator=(const InternedHashSet& s) = delete;
+    InternedHashSet(InternedHashSet&& s) noexcept;
+    InternedHashSet& operator=(InternedHashSet&& s) noexcept;
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() adds a word to the set, copying its characters into the arena
+    // only if it isn't already there.
+    void add(const std::string& element) override;
+
+
+    // contains() returns true if the given word is in the set, false
+    // otherwise.  containsKey() does the same for a std::string_view.
+    bool contains(const std::string& element) const override;
+    bool containsKey(std::string_view element) const;
+
+
+    // size() returns the number of words in the set.
+    unsigned int size() const noexcept override;
+
+
+    // modificationCount() returns the number of words added since the set
+    // was built (see ModificationCounted.hpp).
+    std::uint64_t modificationCount() const noexcept override;
+
+
+    // strings() returns the arena holding the words' characters.
+    const StringArena& strings() const noexcept;
+
+
+private:
+    // The arena is allocated separately, so that it stays where the
+    // HashSet's policies expect it when the set is moved.
+    std::unique_ptr<StringArena> arena;
+    HashSet<StringHandle, ArenaHasher, ArenaEqual> handles;
+};
+
+
+
+#endif
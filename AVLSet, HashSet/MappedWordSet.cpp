@@ -0,0 +1,307 @@
+// MappedWordSet.cpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Implementation of the MappedWordSet class.  See MappedWordSet.hpp for
+// the layout of a snapshot.
+
+#include "MappedWordSet.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "HashPolicy.hpp"
+
+
+namespace
+{
+    std::runtime_error snapshotError(const std::string& path, const std::string& problem)
+    {
+        return std::runtime_error{"snapshot " + path + ": " + problem};
+    }
+}
+
+
+MappedWordSet::MappedWordSet(const std::string& path)
+    : mapping{nullptr}, mappingSize{0}
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw snapshotError(path, std::strerror(errno));
+    }
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0)
+    {
+        int error = errno;
+        ::close(fd);
+        throw snapshotError(path, std::strerror(error));
+    }
+
+    mappingSize = static_cast<std::size_t>(status.st_size);
+    if (mappingSize < sizeof(Header))
+    {
+        ::close(fd);
+        throw snapshotError(path, "too short to be a snapshot");
+    }
+
+    // The mapping stays valid after the file is closed.
+    mapping = ::mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    int error = errno;
+    ::close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        mapping = nullptr;
+        throw snapshotError(path, std::strerror(error));
+    }
+
+    // Only the header is checked, so that opening takes the same time
+    // however large the snapshot is.  Lookups check that every offset
+    // they follow stays within the mapping, so a damaged file can give
+    // wrong answers but can't make them read outside of it.
+    const char* bytes = static_cast<const char*>(mapping);
+    header = reinterpret_cast<const Header*>(bytes);
+
+    std::uint64_t expectedSize = 0;
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+        && header->byteOrder == BYTE_ORDER_MARK
+        && header->version == VERSION
+        && header->bucketCount > 0)
+    {
+        expectedSize = sizeof(Header)
+            + sizeof(std::uint32_t) * (std::uint64_t{header->wordCount} + 1)
+            + sizeof(std::uint32_t) * (std::uint64_t{header->bucketCount} + 1)
+            + sizeof(Entry) * std::uint64_t{header->wordCount}
+            + header->arenaSize;
+    }
+
+    if (expectedSize != mappingSize)
+    {
+        ::munmap(mapping, mappingSize);
+        mapping = nullptr;
+        throw snapshotError(path, "not a valid snapshot");
+    }
+
+    offsets = reinterpret_cast<const std::uint32_t*>(bytes + sizeof(Header));
+    buckets = offsets + header->wordCount + 1;
+    entries = reinterpret_cast<const Entry*>(buckets + header->bucketCount + 1);
+    arena = reinterpret_cast<const char*>(entries + header->wordCount);
+}
+
+
+MappedWordSet::~MappedWordSet() noexcept
+{
+    if (mapping != nullptr)
+    {
+        ::munmap(mapping, mappingSize);
+    }
+}
+
+
+MappedWordSet::MappedWordSet(MappedWordSet&& s) noexcept
+    : mapping{nullptr}, mappingSize{0}, header{nullptr}, offsets{nullptr},
+      buckets{nullptr}, entries{nullptr}, arena{nullptr}
+{
+    *this = std::move(s);
+}
+
+
+MappedWordSet& MappedWordSet::operator=(MappedWordSet&& s) noexcept
+{
+    std::swap(mapping, s.mapping);
+    std::swap(mappingSize, s.mappingSize);
+    std::swap(header, s.header);
+    std::swap(offsets, s.offsets);
+    std::swap(buckets, s.buckets);
+    std::swap(entries, s.entries);
+    std::swap(arena, s.arena);
+    return *this;
+}
+
+
+bool MappedWordSet::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+void MappedWordSet::add(const std::string&)
+{
+    throw std::logic_error{"MappedWordSet is read-only"};
+}
+
+
+bool MappedWordSet::contains(const std::string& element) const
+{
+    return containsKey(element);
+}
+
+
+bool MappedWordSet::containsKey(std::string_view element) const noexcept
+{
+    if (header == nullptr)
+    {
+        return false;
+    }
+
+    unsigned int hash = StableStringHasher{}(element);
+    unsigned int bucket = hash % header->bucketCount;
+    std::uint32_t end = std::min(buckets[bucket + 1], header->wordCount);
+
+    for (std::uint32_t i = buckets[bucket]; i < end; ++i)
+    {
+        if (entries[i].hash == hash && wordAt(entries[i].word) == element)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+unsigned int MappedWordSet::size() const noexcept
+{
+    return header == nullptr ? 0 : header->wordCount;
+}
+
+
+std::string_view MappedWordSet::wordAt(unsigned int index) const noexcept
+{
+    if (header == nullptr || index >= header->wordCount)
+    {
+        return std::string_view{};
+    }
+
+    std::uint32_t begin = offsets[index];
+    std::uint32_t end = offsets[index + 1];
+
+    if (begin > end || end > header->arenaSize)
+    {
+        return std::string_view{};
+    }
+
+    return std::string_view{arena + begin, end - begin};
+}
+
+
+void MappedWordSet::scanPrefix(std::string_view prefix, const PrefixVisitor& visit) const
+{
+    forEachWithPrefix(prefix, visit);
+}
+
+
+unsigned int MappedWordSet::lowerBound(std::string_view word) const noexcept
+{
+    unsigned int low = 0;
+    unsigned int high = size();
+
+    while (low < high)
+    {
+        unsigned int middle = low + (high - low) / 2;
+        if (wordAt(middle) < word)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+
+void MappedWordSet::writeSorted(const std::string& path, const std::vector<std::string>& words)
+{
+    std::uint64_t arenaSize = 0;
+    for (const std::string& word: words)
+    {
+        arenaSize += word.size();
+    }
+
+    if (words.size() >= std::numeric_limits<std::uint32_t>::max()
+        || arenaSize > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw snapshotError(path, "too many words to write");
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.version = VERSION;
+    header.wordCount = static_cast<std::uint32_t>(words.size());
+    header.bucketCount = std::max<std::uint32_t>(header.wordCount, 1);
+    header.arenaSize = static_cast<std::uint32_t>(arenaSize);
+
+    std::vector<std::uint32_t> offsets(header.wordCount + 1);
+    std::vector<std::uint32_t> buckets(header.bucketCount + 1, 0);
+    std::vector<Entry> entries(header.wordCount);
+    std::vector<std::uint32_t> hashes(header.wordCount);
+
+    for (std::uint32_t i = 0; i < header.wordCount; ++i)
+    {
+        offsets[i + 1] = offsets[i] + static_cast<std::uint32_t>(words[i].size());
+        hashes[i] = StableStringHasher{}(words[i]);
+        buckets[hashes[i] % header.bucketCount + 1] += 1;
+    }
+
+    // The entries are grouped by bucket with a counting sort: after the
+    // running total, buckets[b] is where bucket b's entries begin, and
+    // next[b] is where its next entry goes.
+    for (std::uint32_t b = 0; b < header.bucketCount; ++b)
+    {
+        buckets[b + 1] += buckets[b];
+    }
+
+    std::vector<std::uint32_t> next{buckets.begin(), buckets.end() - 1};
+    for (std::uint32_t i = 0; i < header.wordCount; ++i)
+    {
+        entries[next[hashes[i] % header.bucketCount]++] = Entry{hashes[i], i};
+    }
+
+    // The snapshot is written to a temporary file that then replaces the
+    // old one, since a process that still has the old one mapped would
+    // crash if the file were rewritten underneath it.
+    std::string temporaryPath = path + ".tmp";
+
+    {
+        std::ofstream out{temporaryPath, std::ios::binary | std::ios::trunc};
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(offsets.data()), sizeof(std::uint32_t) * offsets.size());
+        out.write(reinterpret_cast<const char*>(buckets.data()), sizeof(std::uint32_t) * buckets.size());
+        out.write(reinterpret_cast<const char*>(entries.data()), sizeof(Entry) * entries.size());
+
+        for (const std::string& word: words)
+        {
+            out.write(word.data(), word.size());
+        }
+
+        out.close();
+
+        if (!out)
+        {
+            std::remove(temporaryPath.c_str());
+            throw snapshotError(path, "could not be written");
+        }
+    }
+
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        int error = errno;
+        std::remove(temporaryPath.c_str());
+        throw snapshotError(path, std::strerror(error));
+    }
+}
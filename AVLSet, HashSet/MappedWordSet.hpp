@@ -0,0 +1,190 @@
+// MappedWordSet.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A MappedWordSet is a read-only Set of words that lives in a "snapshot"
+// file, which is mapped into memory with mmap() rather than read.  Opening
+// one does no parsing, hashing or allocation, no matter how many words the
+// snapshot holds; the pages of the file are only read from disk as lookups
+// touch them, and they're shared between every process that maps the same
+// file.
+//
+// A snapshot is written once, by write(), from any range of words (such
+// as an AVLSet, or the lines of a word list).  It's laid out as:
+//
+//     * a Header, identifying the file and giving the sizes of the rest;
+//     * wordCount + 1 offsets into the arena, one per word and one past
+//       the end, with the words in ascending order;
+//     * bucketCount + 1 indexes into the entries, where the entries for
+//       bucket b are the ones from index b up to (but not including) the
+//       index for bucket b + 1;
+//     * wordCount entries, each holding a word's hash and its position in
+//       sorted order, grouped by bucket;
+//     * the arena, holding the characters of every word back to back.
+//
+// The hashes are computed with StableStringHasher (see HashPolicy.hpp), so
+// they mean the same thing in every process.  The numbers are stored in
+// the byte order of the machine that wrote the file, which is checked when
+// it's opened.
+//
+// Because the words are also kept in sorted order, a MappedWordSet can
+// find all of the words with a given prefix, like an AVLSet can.
+
+#ifndef MAPPEDWORDSET_HPP
+#define MAPPEDWORDSET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "PrefixScanner.hpp"
+#include "Set.hpp"
+
+
+
+class MappedWordSet : public Set<std::string>, public PrefixScanner
+{
+public:
+    // Opens the snapshot in the given file.  This throws a
+    // std::runtime_error if the file can't be opened or mapped, or isn't
+    // a valid snapshot.
+    explicit MappedWordSet(const std::string& path);
+
+    // Unmaps the snapshot.
+    ~MappedWordSet() noexcept override;
+
+    MappedWordSet(const MappedWordSet& s) = delete;
+    MappedWordSet& operator=(const MappedWordSet& s) = delete;
+
+    // Initializes a new MappedWordSet that takes over the mapping of an
+    // expiring one.
+    MappedWordSet(MappedWordSet&& s) noexcept;
+
+    // Swaps the mapping of an expiring MappedWordSet with this one's.
+    MappedWordSet& operator=(MappedWordSet&& s) noexcept;
+
+
+    // write() writes a snapshot of the words in the range [first, last)
+    // to the given file, replacing it if it exists.  The words don't need
+    // to be sorted or unique.  This throws a std::runtime_error if the
+    // file can't be written, or if the words are too many or too long for
+    // the offsets in the file to hold.
+    template <typename InputIterator>
+    static void write(const std::string& path, InputIterator first, InputIterator last);
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() always throws a std::logic_error, since a snapshot can't be
+    // changed once it's been written.
+    void add(const std::string& element) override;
+
+
+    // contains() returns true if the given word is in the snapshot, false
+    // otherwise.  This function runs in constant time, looking only at the
+    // words whose hashes fall in the same bucket.
+    bool contains(const std::string& element) const override;
+
+    // containsKey() is like contains(), but takes a std::string_view, so
+    // a word doesn't have to be copied into a std::string to be looked up.
+    bool containsKey(std::string_view element) const noexcept;
+
+
+    // size() returns the number of words in the snapshot.
+    unsigned int size() const noexcept override;
+
+
+    // wordAt() returns the word at the given position in ascending order.
+    std::string_view wordAt(unsigned int index) const noexcept;
+
+
+    // forEachWithPrefix() calls the given "visit" function, in ascending
+    // order, for each of the words that begin with the given prefix, which
+    // takes O(log n + k) time when k words match.  If "visit" returns a
+    // bool, returning false stops the search early.  scanPrefix() does the
+    // same for a caller that only knows the set is a PrefixScanner.
+    template <typename Visit>
+    void forEachWithPrefix(std::string_view prefix, Visit&& visit) const;
+
+    void scanPrefix(std::string_view prefix, const PrefixVisitor& visit) const override;
+
+
+private:
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t byteOrder;
+        std::uint32_t version;
+        std::uint32_t wordCount;
+        std::uint32_t bucketCount;
+        std::uint32_t arenaSize;
+        std::uint32_t reserved;
+    };
+
+    struct Entry
+    {
+        std::uint32_t hash;
+        std::uint32_t word;
+    };
+
+    static constexpr char MAGIC[8] = {'W', 'O', 'R', 'D', 'S', 'E', 'T', '\0'};
+    static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+    static constexpr std::uint32_t VERSION = 1;
+
+    void* mapping;
+    std::size_t mappingSize;
+    const Header* header;
+    const std::uint32_t* offsets;
+    const std::uint32_t* buckets;
+    const Entry* entries;
+    const char* arena;
+
+    static void writeSorted(const std::string& path, const std::vector<std::string>& words);
+    unsigned int lowerBound(std::string_view word) const noexcept;
+};
+
+
+
+template <typename InputIterator>
+void MappedWordSet::write(const std::string& path, InputIterator first, InputIterator last)
+{
+    std::vector<std::string> words{first, last};
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    writeSorted(path, words);
+}
+
+
+template <typename Visit>
+void MappedWordSet::forEachWithPrefix(std::string_view prefix, Visit&& visit) const
+{
+    for (unsigned int i = lowerBound(prefix); i < size(); ++i)
+    {
+        std::string_view word = wordAt(i);
+        if (word.compare(0, prefix.size(), prefix) != 0)
+        {
+            break;
+        }
+
+        if constexpr (std::is_same<decltype(visit(word)), bool>::value)
+        {
+            if (!visit(word))
+            {
+                break;
+            }
+        }
+        else
+        {
+            visit(word);
+        }
+    }
+}
+
+
+
+#endif
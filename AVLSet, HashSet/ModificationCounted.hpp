@@ -0,0 +1,74 @@
+// ModificationCounted.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A ModificationCounted set counts the changes made to it, so that anything
+// remembering answers it gave (such as a SuggestionCache) can tell whether
+// they might be out of date by comparing counts, rather than sizes, which
+// are the same again after a word is removed and another added.
+//
+// Each of the sets that can be changed after it's built keeps its count in
+// a ModificationCounter, and adds one to it whenever an element is added
+// or removed.  A new set starts counting from zero, even when it's a copy
+// of another, while a set that's assigned into (or moved from) counts that
+// as one more change, so the count of a given set never goes back to a
+// number it had with other contents.
+
+#ifndef MODIFICATIONCOUNTED_HPP
+#define MODIFICATIONCOUNTED_HPP
+
+#include <cstdint>
+
+
+
+class ModificationCounted
+{
+public:
+    virtual ~ModificationCounted() noexcept = default;
+
+
+    // modificationCount() returns the number of changes made to the set;
+    // it's different after every change that made a difference.
+    virtual std::uint64_t modificationCount() const noexcept = 0;
+};
+
+
+
+class ModificationCounter
+{
+public:
+    ModificationCounter() noexcept
+        : count{0}
+    {
+    }
+
+    ModificationCounter(const ModificationCounter&) noexcept
+        : count{0}
+    {
+    }
+
+    ModificationCounter& operator=(const ModificationCounter&) noexcept
+    {
+        ++count;
+        return *this;
+    }
+
+    // bump() counts one more change.
+    void bump() noexcept
+    {
+        ++count;
+    }
+
+    std::uint64_t value() const noexcept
+    {
+        return count;
+    }
+
+private:
+    std::uint64_t count;
+};
+
+
+
+#endif
@@ -0,0 +1,295 @@
+// NodePool.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A NodePool is an allocator for the nodes of a linked data structure,
+// shared by AVLSet and HashSet.  Rather than allocating each node
+// separately, it allocates "slabs" of space for many nodes at once and
+// hands the space out one node at a time, so that nodes created together
+// sit next to each other in memory.  The slabs start small and double in
+// size up to a limit, so a small set wastes little space and a large one
+// needs few allocations.
+//
+// Destroyed nodes are kept on a free list and reused by later calls to
+// create().  The slabs themselves are only given back when the whole pool
+// is released, which takes time proportional to the number of slabs, not
+// the number of nodes.  A container being destroyed still has to run the
+// destructors of its nodes before releasing the pool, unless they're
+// trivially destructible.
+//
+// InPlace lets a container construct the value in a node directly from
+// the arguments to its emplace(), rather than constructing it elsewhere
+// and moving it into the node.
+
+#ifndef NODEPOOL_HPP
+#define NODEPOOL_HPP
+
+#include <new>
+#include <tuple>
+#include <utility>
+
+
+
+template <typename Node>
+class NodePool
+{
+public:
+    // The number of nodes in the first slab, and the most that any slab
+    // will hold unless reserve() asks for more.
+    static constexpr unsigned int FIRST_SLAB_SIZE = 32;
+    static constexpr unsigned int MAX_SLAB_SIZE = 4096;
+
+public:
+    // Initializes a NodePool that has no slabs yet.
+    NodePool() noexcept;
+
+    // Releases every slab.  Nodes that are still alive are not destroyed.
+    ~NodePool() noexcept;
+
+    NodePool(const NodePool& p) = delete;
+    NodePool& operator=(const NodePool& p) = delete;
+
+    // Initializes a new NodePool that takes over the slabs of an expiring
+    // one, so that nodes created by it stay valid.
+    NodePool(NodePool&& p) noexcept;
+
+    // Swaps the slabs of an expiring NodePool with this one's.
+    NodePool& operator=(NodePool&& p) noexcept;
+
+
+    // create() constructs a node from the given arguments in the next
+    // free space in the pool, allocating a new slab only if there is none.
+    template <typename... Args>
+    Node* create(Args&&... args);
+
+
+    // destroy() runs the destructor of a node created by this pool and
+    // makes its space available to a later call to create().
+    void destroy(Node* node) noexcept;
+
+
+    // reserve() makes sure that at least count more nodes can be created
+    // without allocating, using a single slab if one is needed.
+    void reserve(unsigned int count);
+
+
+    // release() gives back every slab, without running the destructors of
+    // any nodes that are still alive.  The pool can be used again after.
+    void release() noexcept;
+
+
+    // slabCount() returns the number of slabs currently allocated.
+    unsigned int slabCount() const noexcept;
+
+
+    void swap(NodePool& p) noexcept;
+
+
+private:
+    // Each slot is either the space for one node or, while it's free, a
+    // link to the next free slot.  The first slot of every slab is used
+    // to link the slabs together instead.
+    union Slot
+    {
+        Slot* next;
+        alignas(Node) unsigned char storage[sizeof(Node)];
+    };
+
+    Slot* slabList;
+    Slot* freeList;
+    Slot* nextUnused;
+    Slot* slabEnd;
+    unsigned int nextSlabSize;
+    unsigned int slabTotal;
+
+    void addSlab(unsigned int size);
+};
+
+
+
+// An InPlace holds references to the arguments for constructing a Value,
+// and converts itself to a Value by constructing one from them.  Passed
+// to create() in place of a node's value, it constructs the value right
+// in the node, since the value returned by the conversion initializes the
+// node's member directly, without being copied or moved.  It's only valid
+// until the end of the expression it's made in.
+template <typename Value, typename... Args>
+class InPlace
+{
+public:
+    explicit InPlace(Args&&... args) noexcept
+        : args{std::forward<Args>(args)...}
+    {
+    }
+
+    operator Value()
+    {
+        return std::make_from_tuple<Value>(std::move(args));
+    }
+
+private:
+    std::tuple<Args&&...> args;
+};
+
+
+
+template <typename Node>
+NodePool<Node>::NodePool() noexcept
+    : slabList{nullptr}, freeList{nullptr}, nextUnused{nullptr}, slabEnd{nullptr},
+      nextSlabSize{FIRST_SLAB_SIZE}, slabTotal{0}
+{
+}
+
+
+template <typename Node>
+NodePool<Node>::~NodePool() noexcept
+{
+    release();
+}
+
+
+template <typename Node>
+NodePool<Node>::NodePool(NodePool&& p) noexcept
+    : NodePool()
+{
+    swap(p);
+}
+
+
+template <typename Node>
+NodePool<Node>& NodePool<Node>::operator=(NodePool&& p) noexcept
+{
+    swap(p);
+    return *this;
+}
+
+
+template <typename Node>
+template <typename... Args>
+Node* NodePool<Node>::create(Args&&... args)
+{
+    Slot* slot;
+
+    if (freeList != nullptr)
+    {
+        slot = freeList;
+        freeList = freeList->next;
+    }
+    else
+    {
+        if (nextUnused == slabEnd)
+        {
+            addSlab(nextSlabSize);
+        }
+
+        slot = nextUnused;
+        ++nextUnused;
+    }
+
+    try
+    {
+        return ::new (static_cast<void*>(slot->storage)) Node{std::forward<Args>(args)...};
+    }
+    catch (...)
+    {
+        slot->next = freeList;
+        freeList = slot;
+        throw;
+    }
+}
+
+
+template <typename Node>
+void NodePool<Node>::destroy(Node* node) noexcept
+{
+    node->~Node();
+
+    Slot* slot = reinterpret_cast<Slot*>(node);
+    slot->next = freeList;
+    freeList = slot;
+}
+
+
+template <typename Node>
+void NodePool<Node>::reserve(unsigned int count)
+{
+    unsigned int available = static_cast<unsigned int>(slabEnd - nextUnused);
+
+    for (Slot* slot = freeList; slot != nullptr && available < count; slot = slot->next)
+    {
+        ++available;
+    }
+
+    if (available < count)
+    {
+        // Whatever is left of the current slab goes onto the free list, so
+        // that switching to the new slab doesn't strand it.
+        for (; nextUnused != slabEnd; ++nextUnused)
+        {
+            nextUnused->next = freeList;
+            freeList = nextUnused;
+        }
+
+        addSlab(count - available);
+    }
+}
+
+
+template <typename Node>
+void NodePool<Node>::release() noexcept
+{
+    while (slabList != nullptr)
+    {
+        Slot* next = slabList->next;
+        delete[] slabList;
+        slabList = next;
+    }
+
+    freeList = nullptr;
+    nextUnused = nullptr;
+    slabEnd = nullptr;
+    nextSlabSize = FIRST_SLAB_SIZE;
+    slabTotal = 0;
+}
+
+
+template <typename Node>
+unsigned int NodePool<Node>::slabCount() const noexcept
+{
+    return slabTotal;
+}
+
+
+template <typename Node>
+void NodePool<Node>::swap(NodePool& p) noexcept
+{
+    std::swap(slabList, p.slabList);
+    std::swap(freeList, p.freeList);
+    std::swap(nextUnused, p.nextUnused);
+    std::swap(slabEnd, p.slabEnd);
+    std::swap(nextSlabSize, p.nextSlabSize);
+    std::swap(slabTotal, p.slabTotal);
+}
+
+
+template <typename Node>
+void NodePool<Node>::addSlab(unsigned int size)
+{
+    Slot* slab = new Slot[size + 1];
+    slab->next = slabList;
+    slabList = slab;
+    slabTotal += 1;
+
+    nextUnused = slab + 1;
+    slabEnd = slab + size + 1;
+
+    if (nextSlabSize < MAX_SLAB_SIZE)
+    {
+        nextSlabSize *= 2;
+    }
+}
+
+
+
+#endif
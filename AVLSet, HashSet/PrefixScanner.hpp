@@ -0,0 +1,67 @@
+// PrefixScanner.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A PrefixScanner is a Set of strings that keeps its words in ascending
+// order, so that it can visit just the ones that begin with a given prefix
+// without looking at the rest.  WordChecker::autocomplete() works with any
+// Set that is also a PrefixScanner, rather than knowing about each kind of
+// ordered Set separately.
+//
+// AVLSet and BPlusTreeSet are PrefixScanners only when their elements are
+// std::strings in their usual order, since the prefix search relies on
+// every word with a given prefix sitting together, starting at the prefix
+// itself.  For any other kind of element, they derive from the empty
+// NoPrefixScanner instead (see PrefixScannerBase).
+
+#ifndef PREFIXSCANNER_HPP
+#define PREFIXSCANNER_HPP
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+
+
+class PrefixScanner
+{
+public:
+    // A PrefixVisitor is called with each word found, and returns false to
+    // stop the scan early.
+    using PrefixVisitor = std::function<bool(std::string_view)>;
+
+public:
+    virtual ~PrefixScanner() noexcept = default;
+
+
+    // scanPrefix() calls visit(word), in ascending order, for each of the
+    // words that begin with the given prefix, until visit returns false.
+    virtual void scanPrefix(std::string_view prefix, const PrefixVisitor& visit) const = 0;
+};
+
+
+
+class NoPrefixScanner
+{
+};
+
+
+
+// isPrefixScannable is true when a set of ElementType ordered by Compare
+// keeps strings in their usual order, and PrefixScannerBase is the base
+// class that such a set derives from.
+template <typename ElementType, typename Compare = std::less<>>
+inline constexpr bool isPrefixScannable =
+    std::is_same<ElementType, std::string>::value
+    && (std::is_same<Compare, std::less<std::string>>::value || std::is_same<Compare, std::less<>>::value);
+
+
+template <typename ElementType, typename Compare = std::less<>>
+using PrefixScannerBase = std::conditional_t<
+    isPrefixScannable<ElementType, Compare>, PrefixScanner, NoPrefixScanner>;
+
+
+
+#endif
@@ -0,0 +1,284 @@
+// SpellCheckStream.cpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Implementation of the SpellCheckStream class.
+
+#include "SpellCheckStream.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace
+{
+    std::runtime_error streamError(const std::string& path, const std::string& problem)
+    {
+        return std::runtime_error{"spell check " + path + ": " + problem};
+    }
+
+
+    bool isLetter(char c) noexcept
+    {
+        return static_cast<unsigned char>((c | 0x20) - 'a') < 26;
+    }
+}
+
+
+SpellCheckStream::Options SpellCheckStream::defaultOptions() noexcept
+{
+    return Options{4096, std::size_t{16} << 20, 1, false, true};
+}
+
+
+SpellCheckStream::SpellCheckStream(const WordChecker& checker, const std::string& path)
+    : SpellCheckStream{checker, path, defaultOptions()}
+{
+}
+
+
+SpellCheckStream::SpellCheckStream(
+    const WordChecker& checker, const std::string& path, const Options& options)
+    : checker{checker}, options{options}, path{path}, fd{-1}, size{0},
+      pageSize{static_cast<std::size_t>(::sysconf(_SC_PAGESIZE))},
+      window{nullptr}, windowStart{0}, windowEnd{0}, position{0}, skippingRun{false},
+      wordCount{0}, misspelledCount{0}
+{
+    // The window has to hold a whole word after the partial page it starts
+    // with, so it's never smaller than a few pages.
+    this->options.batchSize = std::max<std::size_t>(options.batchSize, 1);
+    this->options.windowSize = std::max(
+        (options.windowSize + pageSize - 1) / pageSize * pageSize,
+        (MAX_WORD_LENGTH / pageSize + 4) * pageSize);
+
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw streamError(path, std::strerror(errno));
+    }
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0)
+    {
+        int error = errno;
+        ::close(fd);
+        throw streamError(path, std::strerror(error));
+    }
+
+    size = static_cast<std::uint64_t>(status.st_size);
+
+    words.resize(this->options.batchSize);
+    views.reserve(this->options.batchSize);
+    offsets.reserve(this->options.batchSize);
+    exists = std::make_unique<bool[]>(this->options.batchSize);
+}
+
+
+SpellCheckStream::~SpellCheckStream() noexcept
+{
+    if (window != nullptr)
+    {
+        ::munmap(window, windowEnd - windowStart);
+    }
+
+    ::close(fd);
+}
+
+
+bool SpellCheckStream::next(std::vector<Misspelling>& misspellings)
+{
+    misspellings.clear();
+
+    // A batch stops wherever a word might continue past the end of the
+    // window, and the window is only moved between batches, so that the
+    // words in a batch (and the misspellings returned) stay valid until
+    // next() is called again.
+    std::size_t count = 0;
+
+    while (count == 0 && position < size)
+    {
+        if (window == nullptr || (windowEnd < size && position + MAX_WORD_LENGTH + 1 > windowEnd))
+        {
+            moveWindow();
+        }
+
+        count = fillBatch();
+    }
+
+    if (count == 0)
+    {
+        return false;
+    }
+
+    checker.wordsExist(words.data(), count, exists.get(), options.threadCount);
+    wordCount += count;
+
+    // The misspelled words are swapped to the front of the batch, so that
+    // their suggestions can be found with one more call, and the strings
+    // keep their capacity for the next batch either way.
+    std::size_t misspelled = 0;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (!exists[i])
+        {
+            misspellings.push_back(Misspelling{views[i], offsets[i], {}});
+            words[misspelled++].swap(words[i]);
+        }
+    }
+
+    misspelledCount += misspelled;
+
+    if (options.suggest && misspelled > 0)
+    {
+        std::vector<WordChecker::WordCheckResult> results =
+            checker.checkWords(words.data(), misspelled, options.threadCount);
+
+        for (std::size_t i = 0; i < misspelled; ++i)
+        {
+            misspellings[i].suggestions = std::move(results[i].suggestions);
+        }
+    }
+
+    return true;
+}
+
+
+std::uint64_t SpellCheckStream::fileSize() const noexcept
+{
+    return size;
+}
+
+
+std::uint64_t SpellCheckStream::bytesChecked() const noexcept
+{
+    return position;
+}
+
+
+std::uint64_t SpellCheckStream::wordsChecked() const noexcept
+{
+    return wordCount;
+}
+
+
+std::uint64_t SpellCheckStream::misspellingCount() const noexcept
+{
+    return misspelledCount;
+}
+
+
+void SpellCheckStream::moveWindow()
+{
+    if (window != nullptr)
+    {
+        ::munmap(window, windowEnd - windowStart);
+        window = nullptr;
+    }
+
+    std::uint64_t start = position / pageSize * pageSize;
+    std::size_t length = static_cast<std::size_t>(std::min<std::uint64_t>(options.windowSize, size - start));
+
+    void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(start));
+    if (mapping == MAP_FAILED)
+    {
+        throw streamError(path, std::strerror(errno));
+    }
+
+    // The window is only read once, from front to back, so the kernel can
+    // read ahead of it and drop its pages soon after.
+    ::madvise(mapping, length, MADV_SEQUENTIAL);
+
+    window = static_cast<char*>(mapping);
+    windowStart = start;
+    windowEnd = start + length;
+}
+
+
+std::size_t SpellCheckStream::fillBatch()
+{
+    // Returns the number of words found between position and the end of
+    // the window, up to a batch's worth, and moves position past them.
+    // Within the window, p and end are offsets from windowStart.
+    std::size_t p = static_cast<std::size_t>(position - windowStart);
+    std::size_t end = static_cast<std::size_t>(windowEnd - windowStart);
+    bool lastWindow = windowEnd == size;
+
+    views.clear();
+    offsets.clear();
+
+    if (skippingRun)
+    {
+        while (p < end && isLetter(window[p]))
+        {
+            ++p;
+        }
+
+        skippingRun = p == end && !lastWindow;
+    }
+
+    while (views.size() < options.batchSize)
+    {
+        while (p < end && !isLetter(window[p]))
+        {
+            ++p;
+        }
+
+        if (p == end)
+        {
+            break;
+        }
+
+        std::size_t start = p;
+        std::size_t limit = std::min(end, start + MAX_WORD_LENGTH + 1);
+
+        while (p < limit && isLetter(window[p]))
+        {
+            ++p;
+        }
+
+        if (p - start > MAX_WORD_LENGTH)
+        {
+            while (p < end && isLetter(window[p]))
+            {
+                ++p;
+            }
+
+            skippingRun = p == end && !lastWindow;
+        }
+        else if (p == end && !lastWindow)
+        {
+            p = start;
+            break;
+        }
+        else
+        {
+            std::string& word = words[views.size()];
+            word.assign(window + start, p - start);
+
+            if (options.uppercase)
+            {
+                for (char& c: word)
+                {
+                    if (c >= 'a' && c <= 'z')
+                    {
+                        c = static_cast<char>(c - 'a' + 'A');
+                    }
+                }
+            }
+
+            views.emplace_back(window + start, p - start);
+            offsets.push_back(windowStart + start);
+        }
+    }
+
+    position = windowStart + p;
+    return views.size();
+}
@@ -0,0 +1,162 @@
+// SpellCheckStream.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A SpellCheckStream checks the spelling of every word in a text file of
+// any size, using a WordChecker, and reports each misspelled word along
+// with its offset in the file, a batch at a time, as it goes.
+//
+// The file is never read into memory.  Instead, a window of it is mapped
+// with mmap(), and moved along the file as the words in it are checked,
+// so the memory used is the same whether the file is a kilobyte or many
+// gigabytes.  The words are found in the window as std::string_views,
+// without being copied, and collected into batches; each batch is then
+// checked with one call to WordChecker::wordsExist(), which can spread it
+// over several threads.  Since a Set looks up std::strings, each word is
+// copied into one of a batch's worth of strings that are reused from one
+// batch to the next, so checking a word never allocates memory.
+//
+// A word is a run of ASCII letters; everything else separates words.  By
+// default, words are converted to uppercase before they're checked, since
+// that's how the words in the dictionary are written.  A run of letters
+// longer than MAX_WORD_LENGTH can't be a word, and is skipped.
+
+#ifndef SPELLCHECKSTREAM_HPP
+#define SPELLCHECKSTREAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "WordChecker.hpp"
+
+
+
+class SpellCheckStream
+{
+public:
+    // Options control how a file is checked: how many words are in each
+    // batch, how many bytes of the file are mapped at a time (which is
+    // rounded up to a whole number of pages, and to at least a few), how
+    // many threads check each batch (0 meaning one per hardware thread),
+    // whether suggestions are found for the misspelled words, and whether
+    // words are converted to uppercase before they're checked.
+    struct Options
+    {
+        std::size_t batchSize;
+        std::size_t windowSize;
+        unsigned int threadCount;
+        bool suggest;
+        bool uppercase;
+    };
+
+    // A Misspelling is a misspelled word, as it appears in the file, and
+    // its offset from the start of the file.  The word is only valid until
+    // the next call to next(), since it refers to the mapped window.
+    struct Misspelling
+    {
+        std::string_view word;
+        std::uint64_t offset;
+        std::vector<std::string> suggestions;
+    };
+
+    // The longest run of letters that's checked as a word.
+    static constexpr std::size_t MAX_WORD_LENGTH = 256;
+
+    // The options used unless others are given: batches of 4,096 words,
+    // a 16 MB window, one thread, no suggestions, and converting words to
+    // uppercase.
+    static Options defaultOptions() noexcept;
+
+public:
+    // Opens the given file to be checked with the given WordChecker, which
+    // must outlive the stream.  This throws a std::runtime_error if the
+    // file can't be opened.
+    SpellCheckStream(const WordChecker& checker, const std::string& path);
+    SpellCheckStream(const WordChecker& checker, const std::string& path, const Options& options);
+
+    // Unmaps the window and closes the file.
+    ~SpellCheckStream() noexcept;
+
+    SpellCheckStream(const SpellCheckStream& s) = delete;
+    SpellCheckStream& operator=(const SpellCheckStream& s) = delete;
+
+
+    // next() checks the next batch of words in the file, replacing the
+    // contents of misspellings with the ones it finds, in the order they
+    // appear.  It returns false, leaving misspellings empty, once the whole
+    // file has been checked.  This throws a std::runtime_error if part of
+    // the file can't be mapped.
+    bool next(std::vector<Misspelling>& misspellings);
+
+
+    // run() checks the rest of the file, calling emit(misspelling) for
+    // each misspelling, in order, as soon as its batch has been checked.
+    template <typename Emit>
+    void run(Emit&& emit);
+
+
+    // fileSize() returns the size of the file, and bytesChecked() how much
+    // of it has been checked so far.  wordsChecked() and misspellingCount()
+    // return the number of words checked so far, and how many of those
+    // were misspelled.
+    std::uint64_t fileSize() const noexcept;
+    std::uint64_t bytesChecked() const noexcept;
+    std::uint64_t wordsChecked() const noexcept;
+    std::uint64_t misspellingCount() const noexcept;
+
+
+private:
+    const WordChecker& checker;
+    Options options;
+    std::string path;
+    int fd;
+    std::uint64_t size;
+    std::size_t pageSize;
+
+    // The window maps the bytes of the file from windowStart (a multiple
+    // of the page size) up to windowEnd.  position is the offset of the
+    // first byte that hasn't been checked, and skippingRun is true while
+    // the letters there belong to a run too long to be a word.
+    char* window;
+    std::uint64_t windowStart;
+    std::uint64_t windowEnd;
+    std::uint64_t position;
+    bool skippingRun;
+
+    // One batch's worth of words and where they were found; the strings
+    // keep their capacity from one batch to the next.
+    std::vector<std::string> words;
+    std::vector<std::string_view> views;
+    std::vector<std::uint64_t> offsets;
+    std::unique_ptr<bool[]> exists;
+
+    std::uint64_t wordCount;
+    std::uint64_t misspelledCount;
+
+    void moveWindow();
+    std::size_t fillBatch();
+};
+
+
+
+template <typename Emit>
+void SpellCheckStream::run(Emit&& emit)
+{
+    std::vector<Misspelling> misspellings;
+
+    while (next(misspellings))
+    {
+        for (const Misspelling& misspelling: misspellings)
+        {
+            emit(misspelling);
+        }
+    }
+}
+
+
+
+#endif
@@ -0,0 +1,62 @@
+// StringArena.cpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Implementation of the StringArena class.
+
+#include "StringArena.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+
+StringArena::StringArena() noexcept
+    : chunkUsed{0}, totalUsed{0}
+{
+}
+
+
+StringHandle StringArena::append(std::string_view s)
+{
+    if (s.size() > CHUNK_SIZE)
+    {
+        throw std::length_error{"string is too long for a StringArena"};
+    }
+
+    // A string that doesn't fit in what's left of the last chunk starts a
+    // new one, leaving the rest of the last one unused.  An empty string
+    // starts one too when there are no chunks or the last one is full, so
+    // that every handle's offset is within a chunk that exists.
+    if (chunks.empty() || chunkUsed == CHUNK_SIZE || CHUNK_SIZE - chunkUsed < s.size())
+    {
+        if (chunks.size() == MAX_CHUNKS)
+        {
+            throw std::length_error{"StringArena is full"};
+        }
+
+        chunks.push_back(std::unique_ptr<char[]>{new char[CHUNK_SIZE]});
+        chunkUsed = 0;
+    }
+
+    StringHandle handle{
+        static_cast<std::uint32_t>((chunks.size() - 1) * CHUNK_SIZE + chunkUsed),
+        static_cast<std::uint32_t>(s.size())};
+
+    std::copy(s.begin(), s.end(), chunks.back().get() + chunkUsed);
+    chunkUsed += static_cast<std::uint32_t>(s.size());
+    totalUsed += s.size();
+
+    return handle;
+}
+
+
+std::size_t StringArena::bytesUsed() const noexcept
+{
+    return totalUsed;
+}
+
+
+std::size_t StringArena::bytesAllocated() const noexcept
+{
+    return chunks.size() * CHUNK_SIZE;
+}
@@ -0,0 +1,182 @@
+// StringArena.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A StringArena stores the characters of many strings back to back in a
+// few large chunks of memory, and identifies each string by a
+// StringHandle: its offset into the arena and its length, in eight bytes.
+// Compared to a std::string, which is 32 bytes before any of its
+// characters are stored and allocates them separately once they outgrow
+// it, this makes a large dictionary a fraction of the size, with all of
+// its characters in a handful of allocations.
+//
+// Strings can only be appended to an arena, never removed or changed, so
+// a handle stays valid for as long as its arena does.  A string never
+// spans two chunks, so it can be viewed as one std::string_view.
+//
+// ArenaHasher, ArenaEqual and ArenaLess are the policies that let a
+// HashSet or an AVLSet hold StringHandles while hashing and comparing the
+// strings they refer to.  Each of them also accepts a std::string_view in
+// place of a handle, so that a word can be looked up with containsKey()
+// without being added to the arena first.  InternedHashSet and
+// InternedAVLSet are Sets of std::strings built this way.
+
+#ifndef STRINGARENA_HPP
+#define STRINGARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+
+
+struct StringHandle
+{
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+
+
+class StringArena
+{
+public:
+    // The size of each chunk, which is also the longest string an arena
+    // can hold.
+    static constexpr std::uint32_t CHUNK_SIZE = 1u << 16;
+
+    // The most chunks an arena can have, so that every offset fits in a
+    // StringHandle.
+    static constexpr std::size_t MAX_CHUNKS = (std::size_t{1} << 32) / CHUNK_SIZE;
+
+public:
+    // Initializes an empty StringArena, which allocates no memory until
+    // a string is appended to it.
+    StringArena() noexcept;
+
+    // An arena is only ever moved, never copied, since copying one would
+    // leave the sets holding its handles referring to the original.
+    StringArena(const StringArena& a) = delete;
+    StringArena& operator=(const StringArena& a) = delete;
+    StringArena(StringArena&& a) noexcept = default;
+    StringArena& operator=(StringArena&& a) noexcept = default;
+
+
+    // append() copies the given string into the arena and returns its
+    // handle.  This throws a std::length_error if the string is longer
+    // than CHUNK_SIZE or the arena is full.
+    StringHandle append(std::string_view s);
+
+
+    // view() returns the string with the given handle.
+    std::string_view view(StringHandle handle) const noexcept
+    {
+        return std::string_view{
+            chunks[handle.offset / CHUNK_SIZE].get() + handle.offset % CHUNK_SIZE,
+            handle.length};
+    }
+
+
+    // bytesUsed() returns the number of characters stored in the arena,
+    // and bytesAllocated() the total size of its chunks.
+    std::size_t bytesUsed() const noexcept;
+    std::size_t bytesAllocated() const noexcept;
+
+
+private:
+    std::vector<std::unique_ptr<char[]>> chunks;
+
+    // The number of characters in the last chunk, and in all of them.
+    std::uint32_t chunkUsed;
+    std::size_t totalUsed;
+};
+
+
+
+// ArenaHasher hashes the string that a handle refers to, in the same way
+// as DefaultHasher<std::string> would hash an equal std::string.
+class ArenaHasher
+{
+public:
+    explicit ArenaHasher(const StringArena* arena = nullptr) noexcept
+        : arena{arena}
+    {
+    }
+
+    unsigned int operator()(StringHandle handle) const noexcept
+    {
+        return (*this)(arena->view(handle));
+    }
+
+    unsigned int operator()(std::string_view s) const noexcept
+    {
+        std::size_t hash = std::hash<std::string_view>{}(s);
+        return static_cast<unsigned int>(hash ^ (hash >> (sizeof(std::size_t) * 4)));
+    }
+
+private:
+    const StringArena* arena;
+};
+
+
+
+// ArenaEqual compares the strings that handles refer to.
+class ArenaEqual
+{
+public:
+    explicit ArenaEqual(const StringArena* arena = nullptr) noexcept
+        : arena{arena}
+    {
+    }
+
+    bool operator()(StringHandle a, StringHandle b) const noexcept
+    {
+        return arena->view(a) == arena->view(b);
+    }
+
+    bool operator()(StringHandle a, std::string_view b) const noexcept
+    {
+        return arena->view(a) == b;
+    }
+
+private:
+    const StringArena* arena;
+};
+
+
+
+// ArenaLess orders handles by the strings they refer to.
+class ArenaLess
+{
+public:
+    explicit ArenaLess(const StringArena* arena = nullptr) noexcept
+        : arena{arena}
+    {
+    }
+
+    bool operator()(StringHandle a, StringHandle b) const noexcept
+    {
+        return arena->view(a) < arena->view(b);
+    }
+
+    bool operator()(StringHandle a, std::string_view b) const noexcept
+    {
+        return arena->view(a) < b;
+    }
+
+    bool operator()(std::string_view a, StringHandle b) const noexcept
+    {
+        return a < arena->view(b);
+    }
+
+private:
+    const StringArena* arena;
+};
+
+
+
+#endif
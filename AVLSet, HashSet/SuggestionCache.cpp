@@ -0,0 +1,160 @@
+// SuggestionCache.cpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Implementation of the SuggestionCache class.
+
+#include "SuggestionCache.hpp"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+
+SuggestionCache::SuggestionCache(std::size_t capacity, unsigned int shardCount)
+{
+    if (capacity == 0 || shardCount == 0)
+    {
+        throw std::invalid_argument{"a SuggestionCache needs a capacity and at least one shard"};
+    }
+
+    // The capacity is divided evenly, so a cache may hold a few more words
+    // than asked for, but never has a shard that can't hold any.
+    this->shardCount = static_cast<unsigned int>(std::min<std::size_t>(shardCount, capacity));
+    shardCapacity = (capacity + this->shardCount - 1) / this->shardCount;
+    shards = std::make_unique<Shard[]>(this->shardCount);
+}
+
+
+bool SuggestionCache::find(const std::string& word, std::uint64_t version, std::vector<std::string>& suggestions)
+{
+    Shard& shard = shardOf(word);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+
+    auto found = shard.positions.find(word);
+
+    if (found == shard.positions.end())
+    {
+        ++shard.counts.misses;
+        return false;
+    }
+    else if (found->second->version != version)
+    {
+        ++shard.counts.misses;
+        ++shard.counts.stale;
+        return false;
+    }
+
+    shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+    suggestions = found->second->suggestions;
+    ++shard.counts.hits;
+    return true;
+}
+
+
+void SuggestionCache::insert(
+    const std::string& word, std::uint64_t version, const std::vector<std::string>& suggestions)
+{
+    Shard& shard = shardOf(word);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+
+    auto found = shard.positions.find(word);
+
+    if (found != shard.positions.end())
+    {
+        found->second->version = version;
+        found->second->suggestions = suggestions;
+        shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+        return;
+    }
+
+    // The least recently used entry is reused for the new word rather than
+    // being destroyed, which saves freeing one list node and allocating
+    // another.
+    if (shard.entries.size() == shardCapacity)
+    {
+        auto oldest = std::prev(shard.entries.end());
+        shard.positions.erase(oldest->word);
+        ++shard.counts.evictions;
+
+        oldest->word = word;
+        oldest->version = version;
+        oldest->suggestions = suggestions;
+        shard.entries.splice(shard.entries.begin(), shard.entries, oldest);
+    }
+    else
+    {
+        shard.entries.push_front(Entry{word, version, suggestions});
+    }
+
+    shard.positions.emplace(shard.entries.front().word, shard.entries.begin());
+}
+
+
+void SuggestionCache::clear()
+{
+    for (unsigned int i = 0; i < shardCount; ++i)
+    {
+        std::lock_guard<std::mutex> lock{shards[i].mutex};
+        shards[i].positions.clear();
+        shards[i].entries.clear();
+    }
+}
+
+
+std::size_t SuggestionCache::size() const
+{
+    std::size_t total = 0;
+
+    for (unsigned int i = 0; i < shardCount; ++i)
+    {
+        std::lock_guard<std::mutex> lock{shards[i].mutex};
+        total += shards[i].entries.size();
+    }
+
+    return total;
+}
+
+
+std::size_t SuggestionCache::capacity() const noexcept
+{
+    return shardCapacity * shardCount;
+}
+
+
+SuggestionCache::Stats SuggestionCache::stats() const
+{
+    Stats total{0, 0, 0, 0};
+
+    for (unsigned int i = 0; i < shardCount; ++i)
+    {
+        std::lock_guard<std::mutex> lock{shards[i].mutex};
+        total.hits += shards[i].counts.hits;
+        total.misses += shards[i].counts.misses;
+        total.stale += shards[i].counts.stale;
+        total.evictions += shards[i].counts.evictions;
+    }
+
+    return total;
+}
+
+
+void SuggestionCache::resetStats()
+{
+    for (unsigned int i = 0; i < shardCount; ++i)
+    {
+        std::lock_guard<std::mutex> lock{shards[i].mutex};
+        shards[i].counts = Stats{0, 0, 0, 0};
+    }
+}
+
+
+SuggestionCache::Shard& SuggestionCache::shardOf(const std::string& word) noexcept
+{
+    // The shard is chosen by the hash's high bits, since the hash tables
+    // within the shards use its low ones.
+    std::size_t hash = std::hash<std::string>{}(word);
+    return shards[(hash >> (sizeof(std::size_t) * 4)) % shardCount];
+}
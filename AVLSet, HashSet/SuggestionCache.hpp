@@ -0,0 +1,127 @@
+// SuggestionCache.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A SuggestionCache remembers the suggestions that were found for the
+// words most recently looked up, so that a WordChecker asked about the
+// same misspelling again can return them without trying every candidate
+// again (see WordChecker::setSuggestionCache()).  It holds at most a fixed
+// number of words, and when it's full, the one used least recently is
+// forgotten to make room for a new one.
+//
+// The words are divided between shards by their hashes.  Each shard is a
+// list of its words from the most to the least recently used, along with
+// a hash table that finds each word's place in the list, so finding,
+// adding and forgetting a word all take O(1) time.  Each shard has its own
+// mutex, so threads sharing a cache (such as those of checkWords()) only
+// wait for one another when they use words in the same shard.
+//
+// Each set of suggestions is stored along with a version, chosen by the
+// caller, of the Set it was found in; it's only returned to a caller
+// asking with the same version, so that a change to the Set makes every
+// stored word miss without the cache having to be emptied all at once.
+
+#ifndef SUGGESTIONCACHE_HPP
+#define SUGGESTIONCACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+
+class SuggestionCache
+{
+public:
+    // Stats counts the lookups made in the cache since it was built or the
+    // counts were last reset: how many found the word (hits), how many
+    // didn't (misses), how many of those misses found it stored with an
+    // older version of the Set (stale), and how many words were forgotten
+    // to make room for others (evictions).
+    struct Stats
+    {
+        unsigned long long hits;
+        unsigned long long misses;
+        unsigned long long stale;
+        unsigned long long evictions;
+    };
+
+    // The number of shards a cache is divided into unless another number
+    // is asked for.
+    static constexpr unsigned int DEFAULT_SHARD_COUNT = 16;
+
+public:
+    // Initializes an empty cache that holds up to capacity words, divided
+    // into shardCount shards (or fewer, if there are fewer words than
+    // that).  This throws a std::invalid_argument if either is 0.
+    explicit SuggestionCache(std::size_t capacity, unsigned int shardCount = DEFAULT_SHARD_COUNT);
+
+    SuggestionCache(const SuggestionCache& c) = delete;
+    SuggestionCache& operator=(const SuggestionCache& c) = delete;
+
+
+    // find() copies the suggestions stored for the given word into
+    // suggestions and returns true if they were stored with the given
+    // version, making the word the most recently used in its shard, or
+    // returns false otherwise.
+    bool find(const std::string& word, std::uint64_t version, std::vector<std::string>& suggestions);
+
+
+    // insert() stores the suggestions for the given word with the given
+    // version, replacing any already stored for it, and forgets the least
+    // recently used word in its shard if the shard was full.
+    void insert(const std::string& word, std::uint64_t version, const std::vector<std::string>& suggestions);
+
+
+    // clear() forgets every word in the cache, but not the counts.
+    void clear();
+
+
+    // size() returns the number of words in the cache, and capacity() the
+    // most it can hold.
+    std::size_t size() const;
+    std::size_t capacity() const noexcept;
+
+
+    // stats() returns the counts of lookups made in the cache, and
+    // resetStats() sets them back to zero.
+    Stats stats() const;
+    void resetStats();
+
+
+private:
+    struct Entry
+    {
+        std::string word;
+        std::uint64_t version;
+        std::vector<std::string> suggestions;
+    };
+
+    // The hash table's keys are views of the words in the list, whose
+    // elements never move.  The counts are only changed while the shard's
+    // mutex is held, so they don't need to be atomic.
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        std::list<Entry> entries;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> positions;
+        Stats counts{0, 0, 0, 0};
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    unsigned int shardCount;
+    std::size_t shardCapacity;
+
+    Shard& shardOf(const std::string& word) noexcept;
+};
+
+
+
+#endif
@@ -0,0 +1,293 @@
+// SuggestionIndex.cpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Implementation of the SuggestionIndex class.
+
+#include "SuggestionIndex.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+
+namespace
+{
+    std::uint64_t hashOf(std::string_view s) noexcept
+    {
+        return std::hash<std::string_view>{}(s);
+    }
+
+
+    // forEachDeletion() calls visit(s) with s changed into each string
+    // made by deleting between 1 and remaining of its characters at or
+    // after start, restoring it afterward.  Deleting either of two equal
+    // adjacent characters makes the same string, so only the first of them
+    // is deleted; other repeats are left for the caller to remove.
+    template <typename Visit>
+    void forEachDeletion(std::string& s, std::size_t start, unsigned int remaining, Visit& visit)
+    {
+        if (remaining == 0)
+        {
+            return;
+        }
+
+        for (std::size_t i = start; i < s.size(); ++i)
+        {
+            if (i > start && s[i] == s[i - 1])
+            {
+                continue;
+            }
+
+            char deleted = s[i];
+            s.erase(i, 1);
+            visit(static_cast<const std::string&>(s));
+            forEachDeletion(s, i, remaining - 1, visit);
+            s.insert(i, 1, deleted);
+        }
+    }
+
+
+    // isWithin() returns true if the optimal string alignment distance
+    // between a and b is at most maxDistance, keeping the last three rows
+    // of the distances in rows, and giving up as soon as every entry in a
+    // row is too large.
+    bool isWithin(
+        std::string_view a, std::string_view b, unsigned int maxDistance,
+        std::vector<unsigned int>& rows)
+    {
+        std::size_t width = b.size() + 1;
+        rows.resize(3 * width);
+
+        unsigned int* twoAbove = rows.data();
+        unsigned int* above = twoAbove + width;
+        unsigned int* row = above + width;
+
+        for (std::size_t j = 0; j < width; ++j)
+        {
+            above[j] = static_cast<unsigned int>(j);
+        }
+
+        for (std::size_t i = 1; i <= a.size(); ++i)
+        {
+            row[0] = static_cast<unsigned int>(i);
+            unsigned int smallest = row[0];
+
+            for (std::size_t j = 1; j < width; ++j)
+            {
+                unsigned int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+                unsigned int d = std::min({above[j] + 1, row[j - 1] + 1, above[j - 1] + cost});
+
+                if (i >= 2 && j >= 2 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1])
+                {
+                    d = std::min(d, twoAbove[j - 2] + 1);
+                }
+
+                row[j] = d;
+                smallest = std::min(smallest, d);
+            }
+
+            if (smallest > maxDistance)
+            {
+                return false;
+            }
+
+            std::swap(twoAbove, above);
+            std::swap(above, row);
+        }
+
+        return above[width - 1] <= maxDistance;
+    }
+}
+
+
+SuggestionIndex::SuggestionIndex(const std::vector<std::string>& words, unsigned int maxDistance)
+    : distance{maxDistance}
+{
+    if (words.size() > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw std::length_error{"too many words for a SuggestionIndex"};
+    }
+
+    // Every (deletion, word) pair is made first and sorted, so that the
+    // words recorded for each deletion end up next to each other, in one
+    // array rather than one small vector per deletion.
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> pairs;
+    std::string buffer;
+
+    this->words.reserve(words.size());
+
+    for (const std::string& word: words)
+    {
+        std::uint32_t position = static_cast<std::uint32_t>(this->words.size());
+        this->words.push_back(arena.append(word));
+
+        auto record = [&](const std::string& deletion)
+        {
+            pairs.emplace_back(hashOf(deletion), position);
+        };
+
+        buffer = word;
+        record(buffer);
+        forEachDeletion(buffer, 0, distance, record);
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    if (pairs.size() > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw std::length_error{"too many deletions for a SuggestionIndex"};
+    }
+
+    std::size_t keys = 0;
+    for (std::size_t i = 0; i < pairs.size(); ++i)
+    {
+        if (i == 0 || pairs[i].first != pairs[i - 1].first)
+        {
+            ++keys;
+        }
+    }
+
+    // The table is kept no more than half full, so that a lookup of a
+    // deletion that isn't there soon reaches an empty slot.
+    std::size_t capacity = 2;
+    while (capacity < keys * 2)
+    {
+        capacity *= 2;
+    }
+
+    slots.assign(capacity, Slot{0, 0, 0});
+    postings.reserve(pairs.size());
+
+    std::size_t mask = capacity - 1;
+
+    for (std::size_t i = 0; i < pairs.size(); )
+    {
+        std::uint64_t hash = pairs[i].first;
+        std::uint32_t first = static_cast<std::uint32_t>(postings.size());
+
+        for (; i < pairs.size() && pairs[i].first == hash; ++i)
+        {
+            postings.push_back(pairs[i].second);
+        }
+
+        std::size_t index = hash & mask;
+        while (slots[index].count != 0)
+        {
+            index = (index + 1) & mask;
+        }
+
+        slots[index] = Slot{hash, first, static_cast<std::uint32_t>(postings.size()) - first};
+    }
+}
+
+
+unsigned int SuggestionIndex::maxDistance() const noexcept
+{
+    return distance;
+}
+
+
+unsigned int SuggestionIndex::size() const noexcept
+{
+    return static_cast<unsigned int>(words.size());
+}
+
+
+std::size_t SuggestionIndex::keyCount() const noexcept
+{
+    return static_cast<std::size_t>(std::count_if(slots.begin(), slots.end(),
+        [](const Slot& slot) { return slot.count != 0; }));
+}
+
+
+std::size_t SuggestionIndex::postingCount() const noexcept
+{
+    return postings.size();
+}
+
+
+std::size_t SuggestionIndex::bytesUsed() const noexcept
+{
+    return arena.bytesAllocated()
+        + words.capacity() * sizeof(StringHandle)
+        + slots.capacity() * sizeof(Slot)
+        + postings.capacity() * sizeof(std::uint32_t);
+}
+
+
+std::vector<std::string> SuggestionIndex::wordsWithin(std::string_view word, unsigned int maxDistance) const
+{
+    if (maxDistance > distance)
+    {
+        throw std::invalid_argument{"distance is larger than the SuggestionIndex was built for"};
+    }
+
+    // A word of length m has at most m deletions of one character, and
+    // m(m - 1)/2 of two, which is enough for most words within two edits.
+    std::vector<std::uint64_t> keys;
+    std::string buffer{word};
+    keys.reserve(1 + word.size() + word.size() * (word.size() + 1) / 2);
+
+    auto record = [&](const std::string& deletion)
+    {
+        keys.push_back(hashOf(deletion));
+    };
+
+    record(buffer);
+    forEachDeletion(buffer, 0, maxDistance, record);
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    std::vector<std::uint32_t> candidates;
+
+    for (std::uint64_t key: keys)
+    {
+        if (const Slot* slot = find(key))
+        {
+            candidates.insert(candidates.end(),
+                postings.begin() + slot->first, postings.begin() + slot->first + slot->count);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::vector<std::string> found;
+    std::vector<unsigned int> rows;
+
+    for (std::uint32_t candidate: candidates)
+    {
+        std::string_view s = arena.view(words[candidate]);
+        std::size_t difference = s.size() > word.size() ? s.size() - word.size() : word.size() - s.size();
+
+        if (difference <= maxDistance && isWithin(word, s, maxDistance, rows))
+        {
+            found.emplace_back(s);
+        }
+    }
+
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    return found;
+}
+
+
+const SuggestionIndex::Slot* SuggestionIndex::find(std::uint64_t hash) const noexcept
+{
+    std::size_t mask = slots.size() - 1;
+
+    for (std::size_t index = hash & mask; slots[index].count != 0; index = (index + 1) & mask)
+    {
+        if (slots[index].hash == hash)
+        {
+            return &slots[index];
+        }
+    }
+
+    return nullptr;
+}
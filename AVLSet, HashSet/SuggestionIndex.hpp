@@ -0,0 +1,100 @@
+// SuggestionIndex.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A SuggestionIndex finds the words of a dictionary that are within a few
+// edits of a given word without trying every possible misspelling.  It's
+// built once from the words, up to a chosen distance, and records every
+// string that can be made from each word by deleting up to that many of
+// its characters, along with the words it can be made from.
+//
+// Two words within d edits of each other can always be turned into the
+// same string by deleting no more than d characters from each, so the
+// words close to a given one are all among those recorded for the strings
+// made by deleting its own characters.  A lookup makes only those
+// deletions, which for a short word and a small distance are a few dozen
+// strings, finds each in a hash table, and then checks the distance to
+// each word it turns up.
+//
+// The price is memory: a word of length m has about m^d / d! deletions
+// within distance d, so each extra edit of distance multiplies the size
+// of the index.  Only each deletion's 64-bit hash is kept, not its
+// characters, since a collision can only add a word that the final check
+// of the distance then rejects.  The words themselves are kept in a
+// StringArena.
+
+#ifndef SUGGESTIONINDEX_HPP
+#define SUGGESTIONINDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "StringArena.hpp"
+
+
+
+class SuggestionIndex
+{
+public:
+    // Builds an index of the given words, which can find the words within
+    // up to maxDistance edits of any word.  This throws a std::length_error
+    // if there are too many words or deletions to index.
+    SuggestionIndex(const std::vector<std::string>& words, unsigned int maxDistance);
+
+
+    // maxDistance() returns the largest distance that wordsWithin() can
+    // search within.
+    unsigned int maxDistance() const noexcept;
+
+
+    // size() returns the number of words in the index.
+    unsigned int size() const noexcept;
+
+
+    // keyCount() returns the number of distinct deletions in the index
+    // (including the words themselves), and postingCount() the number of
+    // times a word is recorded for one of them.
+    std::size_t keyCount() const noexcept;
+    std::size_t postingCount() const noexcept;
+
+
+    // bytesUsed() returns the memory taken by the index, including the
+    // characters of its words.
+    std::size_t bytesUsed() const noexcept;
+
+
+    // wordsWithin() returns every word in the index whose edit distance
+    // from the given word is at most maxDistance, in ascending order and
+    // including the word itself if it's in the index.  As in TrieSet, the
+    // distance is the "optimal string alignment" distance, in which
+    // swapping two adjacent characters is one edit.  This throws a
+    // std::invalid_argument if maxDistance is larger than the index was
+    // built for.
+    std::vector<std::string> wordsWithin(std::string_view word, unsigned int maxDistance) const;
+
+
+private:
+    // Each slot of the table holds the hash of one deletion and where its
+    // words' positions are in postings; a slot with no words is empty.
+    struct Slot
+    {
+        std::uint64_t hash;
+        std::uint32_t first;
+        std::uint32_t count;
+    };
+
+    unsigned int distance;
+    StringArena arena;
+    std::vector<StringHandle> words;
+    std::vector<Slot> slots;
+    std::vector<std::uint32_t> postings;
+
+    const Slot* find(std::uint64_t hash) const noexcept;
+};
+
+
+
+#endif
@@ -0,0 +1,244 @@
+// TrieSet.cpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// Implementation of the TrieSet class.
+
+#include "TrieSet.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+
+namespace
+{
+    // Siblings are ordered by their characters as unsigned values, which
+    // is the order std::string compares them in.
+    bool comesBefore(char a, char b) noexcept
+    {
+        return static_cast<unsigned char>(a) < static_cast<unsigned char>(b);
+    }
+}
+
+
+TrieSet::TrieSet()
+    : nodes{Node{NONE, NONE, '\0', false}}, wordCount{0}
+{
+}
+
+
+bool TrieSet::isImplemented() const noexcept
+{
+    return true;
+}
+
+
+void TrieSet::add(const std::string& element)
+{
+    std::uint32_t node = 0;
+
+    for (char character: element)
+    {
+        std::uint32_t previous = NONE;
+        std::uint32_t current = nodes[node].firstChild;
+
+        while (current != NONE && comesBefore(nodes[current].character, character))
+        {
+            previous = current;
+            current = nodes[current].nextSibling;
+        }
+
+        if (current == NONE || nodes[current].character != character)
+        {
+            if (nodes.size() == std::numeric_limits<std::uint32_t>::max())
+            {
+                throw std::length_error{"TrieSet has too many nodes"};
+            }
+
+            std::uint32_t added = static_cast<std::uint32_t>(nodes.size());
+            nodes.push_back(Node{NONE, current, character, false});
+
+            if (previous == NONE)
+            {
+                nodes[node].firstChild = added;
+            }
+            else
+            {
+                nodes[previous].nextSibling = added;
+            }
+
+            current = added;
+        }
+
+        node = current;
+    }
+
+    if (!nodes[node].isWord)
+    {
+        nodes[node].isWord = true;
+        ++wordCount;
+        modifications.bump();
+    }
+}
+
+
+bool TrieSet::contains(const std::string& element) const
+{
+    return containsKey(element);
+}
+
+
+bool TrieSet::containsKey(std::string_view element) const noexcept
+{
+    std::uint32_t node = find(element);
+    return (node != NONE || element.empty()) && nodes[node].isWord;
+}
+
+
+unsigned int TrieSet::size() const noexcept
+{
+    return wordCount;
+}
+
+
+std::uint64_t TrieSet::modificationCount() const noexcept
+{
+    return modifications.value();
+}
+
+
+unsigned int TrieSet::nodeCount() const noexcept
+{
+    return static_cast<unsigned int>(nodes.size());
+}
+
+
+std::vector<std::string> TrieSet::wordsWithin(std::string_view word, unsigned int maxDistance) const
+{
+    // rows holds one row of distances per level of the trie on the path
+    // being searched, each with one entry per prefix of the word: the
+    // entry at level d, column j is the distance from the node's prefix
+    // of length d to the first j characters of the word.  The root's row
+    // is the distance from the empty prefix, which is j.
+    std::size_t width = word.size() + 1;
+    std::vector<unsigned int> rows((word.size() + 2) * width);
+    std::vector<std::string> found;
+    std::string prefix;
+
+    for (std::size_t j = 0; j < width; ++j)
+    {
+        rows[j] = static_cast<unsigned int>(j);
+    }
+
+    if (nodes[0].isWord && word.size() <= maxDistance)
+    {
+        found.push_back(prefix);
+    }
+
+    for (std::uint32_t c = nodes[0].firstChild; c != NONE; c = nodes[c].nextSibling)
+    {
+        prefix.push_back(nodes[c].character);
+        searchFrom(c, 1, prefix, word, maxDistance, rows, found);
+        prefix.pop_back();
+    }
+
+    return found;
+}
+
+
+void TrieSet::scanPrefix(std::string_view prefix, const PrefixVisitor& visit) const
+{
+    forEachWithPrefix(prefix, visit);
+}
+
+
+std::uint32_t TrieSet::child(std::uint32_t node, char character) const noexcept
+{
+    for (std::uint32_t c = nodes[node].firstChild; c != NONE; c = nodes[c].nextSibling)
+    {
+        if (nodes[c].character == character)
+        {
+            return c;
+        }
+        else if (comesBefore(character, nodes[c].character))
+        {
+            break;
+        }
+    }
+
+    return NONE;
+}
+
+
+std::uint32_t TrieSet::find(std::string_view prefix) const noexcept
+{
+    std::uint32_t node = 0;
+
+    for (char character: prefix)
+    {
+        node = child(node, character);
+        if (node == NONE)
+        {
+            break;
+        }
+    }
+
+    return node;
+}
+
+
+void TrieSet::searchFrom(
+    std::uint32_t node, unsigned int depth, std::string& prefix,
+    std::string_view word, unsigned int maxDistance,
+    std::vector<unsigned int>& rows, std::vector<std::string>& found) const
+{
+    // Computes the node's row from its parent's (and, for a swap, its
+    // grandparent's), and only descends if some entry in it is within
+    // maxDistance, since no entry in a child's row can be smaller than
+    // the smallest in its parent's.  The recursion is one level per
+    // character, so it's never deeper than the word plus maxDistance.
+    std::size_t width = word.size() + 1;
+    if (rows.size() < (depth + 1) * width)
+    {
+        rows.resize((depth + 1) * width);
+    }
+
+    unsigned int* row = rows.data() + depth * width;
+    const unsigned int* above = row - width;
+    char character = nodes[node].character;
+
+    row[0] = depth;
+    unsigned int smallest = row[0];
+
+    for (std::size_t j = 1; j < width; ++j)
+    {
+        unsigned int cost = word[j - 1] == character ? 0 : 1;
+        unsigned int distance = std::min({above[j] + 1, row[j - 1] + 1, above[j - 1] + cost});
+
+        if (depth >= 2 && j >= 2 && word[j - 2] == character && word[j - 1] == prefix[depth - 2])
+        {
+            distance = std::min(distance, (above - width)[j - 2] + 1);
+        }
+
+        row[j] = distance;
+        smallest = std::min(smallest, distance);
+    }
+
+    if (nodes[node].isWord && row[width - 1] <= maxDistance)
+    {
+        found.push_back(prefix);
+    }
+
+    if (smallest > maxDistance)
+    {
+        return;
+    }
+
+    for (std::uint32_t c = nodes[node].firstChild; c != NONE; c = nodes[c].nextSibling)
+    {
+        prefix.push_back(nodes[c].character);
+        searchFrom(c, depth + 1, prefix, word, maxDistance, rows, found);
+        prefix.pop_back();
+    }
+}
@@ -0,0 +1,181 @@
+// TrieSet.hpp
+//
+// ICS 46 Spring 2021
+// Project #4: Set the Controls for the Heart of the Sun
+//
+// A TrieSet is a Set of words stored as a trie: a tree with one node per
+// distinct prefix of the words, in which each node's children extend its
+// prefix by one character, and the nodes whose prefixes are whole words
+// are marked as such.  Words that share a prefix share its nodes, so a
+// dictionary with many related words takes far fewer nodes than it has
+// characters.
+//
+// The nodes are kept in one array, and refer to each other by position:
+// each node knows its first child and its next sibling, and the siblings
+// are kept in ascending order of their characters, so each node takes 12
+// bytes and the words can be visited in ascending order.
+//
+// What a trie does well is finding every word close to a given one.
+// wordsWithin() walks the trie once, computing the edit distance from
+// the given word to each node's prefix one row at a time (each node's row
+// follows from its parent's), and only descends into a node while some
+// word below it could still be close enough.  This finds every word
+// within any number of edits, looking only at the parts of the trie that
+// lead to such words, rather than generating every possible misspelling
+// and looking each one up.
+
+#ifndef TRIESET_HPP
+#define TRIESET_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "ModificationCounted.hpp"
+#include "PrefixScanner.hpp"
+#include "Set.hpp"
+
+
+
+class TrieSet : public Set<std::string>, public ModificationCounted, public PrefixScanner
+{
+public:
+    // Initializes an empty TrieSet.
+    TrieSet();
+
+
+    bool isImplemented() const noexcept override;
+
+
+    // add() adds a word to the set, which takes O(m * k) time for a word
+    // of length m, where no node has more than k children.
+    void add(const std::string& element) override;
+
+
+    // contains() returns true if the given word is in the set, false
+    // otherwise.  containsKey() does the same for a std::string_view.
+    // Neither depends on how many words there are.
+    bool contains(const std::string& element) const override;
+    bool containsKey(std::string_view element) const noexcept;
+
+
+    // size() returns the number of words in the set.
+    unsigned int size() const noexcept override;
+
+
+    // modificationCount() returns the number of words added since the set
+    // was built (see ModificationCounted.hpp).
+    std::uint64_t modificationCount() const noexcept override;
+
+
+    // nodeCount() returns the number of nodes in the trie, including the
+    // root, whose prefix is empty.
+    unsigned int nodeCount() const noexcept;
+
+
+    // wordsWithin() returns every word in the set whose edit distance from
+    // the given word is at most maxDistance, in ascending order (including
+    // the word itself, if it's in the set).  The distance is the "optimal
+    // string alignment" distance: the number of characters that must be
+    // inserted, deleted or replaced, or pairs of adjacent characters that
+    // must be swapped, to turn one word into the other, without editing
+    // any part of the word more than once.
+    std::vector<std::string> wordsWithin(std::string_view word, unsigned int maxDistance) const;
+
+
+    // forEachWithPrefix() calls the given "visit" function, in ascending
+    // order, for each of the words that begin with the given prefix.  If
+    // "visit" returns a bool, returning false stops the search early.
+    // scanPrefix() does the same for a caller that only knows the set is a
+    // PrefixScanner.
+    template <typename Visit>
+    void forEachWithPrefix(std::string_view prefix, Visit&& visit) const;
+
+    void scanPrefix(std::string_view prefix, const PrefixVisitor& visit) const override;
+
+
+private:
+    // A node's character is the last one of its prefix.  Since the root
+    // is never anyone's child or sibling, NONE (which is its position)
+    // means that there's no such node.
+    struct Node
+    {
+        std::uint32_t firstChild;
+        std::uint32_t nextSibling;
+        char character;
+        bool isWord;
+    };
+
+    static constexpr std::uint32_t NONE = 0;
+
+    std::vector<Node> nodes;
+    unsigned int wordCount;
+    ModificationCounter modifications;
+
+    std::uint32_t child(std::uint32_t node, char character) const noexcept;
+    std::uint32_t find(std::string_view prefix) const noexcept;
+
+    template <typename Visit>
+    bool visitFrom(std::uint32_t node, std::string& prefix, Visit& visit) const;
+
+    void searchFrom(
+        std::uint32_t node, unsigned int depth, std::string& prefix,
+        std::string_view word, unsigned int maxDistance,
+        std::vector<unsigned int>& rows, std::vector<std::string>& found) const;
+};
+
+
+
+template <typename Visit>
+void TrieSet::forEachWithPrefix(std::string_view prefix, Visit&& visit) const
+{
+    std::uint32_t node = find(prefix);
+
+    if (node != NONE || prefix.empty())
+    {
+        std::string word{prefix};
+        visitFrom(node, word, visit);
+    }
+}
+
+
+template <typename Visit>
+bool TrieSet::visitFrom(std::uint32_t node, std::string& prefix, Visit& visit) const
+{
+    // Visits the node's word, if it is one, and then its children's, in
+    // order; this recurses once per character of the longest word, so the
+    // depth is never large.  Returns false if the visit was stopped.
+    if (nodes[node].isWord)
+    {
+        if constexpr (std::is_same<decltype(visit(prefix)), bool>::value)
+        {
+            if (!visit(static_cast<const std::string&>(prefix)))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            visit(static_cast<const std::string&>(prefix));
+        }
+    }
+
+    for (std::uint32_t c = nodes[node].firstChild; c != NONE; c = nodes[c].nextSibling)
+    {
+        prefix.push_back(nodes[c].character);
+        bool keepGoing = visitFrom(c, prefix, visit);
+        prefix.pop_back();
+
+        if (!keepGoing)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+#endif
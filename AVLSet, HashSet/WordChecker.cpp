@@ -7,104 +7,546 @@
 // the requirements.
 
 #include "WordChecker.hpp"
+#include "HashPolicy.hpp"
+#include "ModificationCounted.hpp"
+#include "PrefixScanner.hpp"
+#include "TrieSet.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+
+namespace
+{
+    const std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+
+    // An Edit describes how a candidate differs from the word it was made
+    // from: which kind of edit was made, at which position and, for an
+    // insertion or replacement, with which character.
+    struct Edit
+    {
+        enum Kind { Swap, Insert, Delete, Replace };
+
+        Kind kind;
+        std::size_t position;
+        char character;
+    };
+
+
+    // forEachCandidate() calls check(candidate, edit) for every candidate
+    // made by the five techniques, in the order they've always been tried.
+    // Every candidate is made by editing one buffer in place and then
+    // undoing the edit, rather than by copying the word.  The buffer has
+    // room for one more character than the word, so none of the edits
+    // ever allocate.
+    template <typename Check>
+    void forEachCandidate(const std::string& word, Check&& check)
+    {
+        std::string candidate;
+        candidate.reserve(word.size() + 1);
+        candidate = word;
+
+        //technique 1: swap each adjacent pair of characters
+        for (std::size_t i=0;i+1<word.size();++i)
+        {
+            std::swap(candidate[i], candidate[i+1]);
+            check(candidate, Edit{Edit::Swap, i, 0});
+            std::swap(candidate[i], candidate[i+1]);
+        }
+
+        //technique 2: insert every character in between (and at the end)
+        for (std::size_t i=0;i<=word.size();++i)
+        {
+            candidate.insert(i, 1, alphabet[0]);
+            for (char character: alphabet)
+            {
+                candidate[i] = character;
+                check(candidate, Edit{Edit::Insert, i, character});
+            }
+            candidate.erase(i, 1);
+        }
+
+        //technique 3: deleting each character from the word
+        for (std::size_t i=0;i<word.size();++i)
+        {
+            candidate.erase(i, 1);
+            check(candidate, Edit{Edit::Delete, i, 0});
+            candidate.insert(i, 1, word[i]);
+        }
+
+        //technique 4: replace every character with each letter
+        for (std::size_t i=0;i<word.size();++i)
+        {
+            for (char character: alphabet)
+            {
+                candidate[i] = character;
+                check(candidate, Edit{Edit::Replace, i, character});
+            }
+            candidate[i] = word[i];
+        }
+
+        //techinique 5: adding a space in between each adjacent pair of characters in the word.
+        for (std::size_t i=0;i<word.size();++i)
+        {
+            candidate.insert(i, 1, ' ');
+            check(candidate, Edit{Edit::Insert, i, ' '});
+            candidate.erase(i, 1);
+        }
+    }
+
+
+    // A CandidateHasher finds the PolynomialHasher hash of any candidate
+    // made from a word by one Edit, in constant time, from the raw hashes
+    // of the word's prefixes and the powers of the base.  All arithmetic is
+    // modulo 2^32, as it is in PolynomialHasher.
+    class CandidateHasher
+    {
+    public:
+        explicit CandidateHasher(const std::string& word)
+            : word{word}, tables(2 * (word.size() + 2))
+        {
+            prefix = tables.data();
+            power = tables.data() + word.size() + 2;
+
+            prefix[0] = 0;
+            power[0] = 1;
+            for (std::size_t i = 0; i <= word.size(); ++i)
+            {
+                if (i < word.size())
+                {
+                    prefix[i + 1] = prefix[i] * PolynomialHasher::BASE + digit(word[i]);
+                }
+                power[i + 1] = power[i] * PolynomialHasher::BASE;
+            }
+        }
+
+        unsigned int operator()(const Edit& edit) const noexcept
+        {
+            std::size_t n = word.size();
+            std::size_t i = edit.position;
+            std::uint32_t whole = prefix[n];
+            std::uint32_t raw = 0;
+
+            switch (edit.kind)
+            {
+            case Edit::Swap:
+                raw = whole
+                    + (digit(word[i + 1]) - digit(word[i])) * power[n - 1 - i]
+                    + (digit(word[i]) - digit(word[i + 1])) * power[n - 2 - i];
+                break;
+
+            case Edit::Insert:
+                raw = (prefix[i] * PolynomialHasher::BASE + digit(edit.character)) * power[n - i]
+                    + suffix(i);
+                break;
+
+            case Edit::Delete:
+                raw = prefix[i] * power[n - i - 1] + suffix(i + 1);
+                break;
+
+            case Edit::Replace:
+                raw = whole + (digit(edit.character) - digit(word[i])) * power[n - 1 - i];
+                break;
+            }
+
+            return PolynomialHasher::finish(raw);
+        }
+
+    private:
+        const std::string& word;
+        std::vector<std::uint32_t> tables;
+        std::uint32_t* prefix;
+        std::uint32_t* power;
+
+        static std::uint32_t digit(char c) noexcept
+        {
+            return static_cast<unsigned char>(c);
+        }
+
+        // suffix() returns the raw hash of the word from position i on.
+        std::uint32_t suffix(std::size_t i) const noexcept
+        {
+            return prefix[word.size()] - prefix[i] * power[word.size() - i];
+        }
+    };
+}
 
 
 WordChecker::WordChecker(const Set<std::string>& words)
-    : words{words}
+    : words{words}, filter{nullptr}, index{nullptr}, cache{nullptr}
 {
 }
 
 
 bool WordChecker::wordExists(const std::string& word) const
 {
-    return words.contains(word);
+    FilterStats tally{0, 0, 0};
+    bool exists = lookup(
+        [&]() { return filter->mightContain(word); },
+        [&]() { return words.contains(word); },
+        tally);
+    record(tally);
+    return exists;
 }
 
 
 std::vector<std::string> WordChecker::findSuggestions(const std::string& word) const
 {
-    // Nonsensical code because the compiler requires the member variables
-    // 'words' to be used somewhere, or else it becomes a warning (which
-    // turns into an error).
-    words.isImplemented();
+    // When the Set is a PolynomialHashLookup, such as a HashSet using a
+    // PolynomialHasher, each candidate's hash is found in constant time
+    // from the Edit that made it, so checking a candidate costs O(1)
+    // hashing instead of O(n), and only candidates whose hashes match are
+    // compared character by character.  A BloomFilter that hashes words
+    // the same way is given the same hash, so it doesn't hash every
+    // candidate from scratch either.
     std::vector<std::string> suggestions;
-    std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    std::uint64_t version = words.size();
+
+    if (auto counted = dynamic_cast<const ModificationCounted*>(&words))
+    {
+        version = counted->modificationCount();
+    }
+
+    if (cache != nullptr && cache->find(word, version, suggestions))
+    {
+        return suggestions;
+    }
+
+    FilterStats tally{0, 0, 0};
 
-    //technique 1: swap each adjacent pair of characters
-    for (int i=0;i<word.size()-1;++i)
+    if (auto rolling = dynamic_cast<const PolynomialHashLookup*>(&words))
     {
-        std::string s1 = word;
-        std::swap(s1[i], s1[i+1]);
-        if (wordExists(s1))
+        CandidateHasher hashOf{word};
+        bool sharesHash = filter != nullptr && filter->hashing() == BloomFilter::Hashing::Polynomial;
+
+        forEachCandidate(word,
+            [&](const std::string& candidate, const Edit& edit)
             {
-                suggestions.push_back(s1);
-            }
+                unsigned int hash = hashOf(edit);
+
+                if (lookup(
+                        [&]()
+                        {
+                            return sharesHash ? filter->mightContainHash(hash) : filter->mightContain(candidate);
+                        },
+                        [&]() { return rolling->containsWithHash(candidate, hash); },
+                        tally))
+                {
+                    suggestions.push_back(candidate);
+                }
+            });
     }
-    
-    //technique 2: insert every character in between
-    for (int i=0;i<word.size();++i)
+    else
     {
-        for (int y=0;y<alphabet.size();++y)
-        {
-            std::string s2 = word;
-            s2.insert(i, alphabet.substr(y, 1));
-            if (wordExists(s2))
+        forEachCandidate(word,
+            [&](const std::string& candidate, const Edit&)
             {
-                suggestions.push_back(s2);
-            }
-        }
+                if (lookup(
+                        [&]() { return filter->mightContain(candidate); },
+                        [&]() { return words.contains(candidate); },
+                        tally))
+                {
+                    suggestions.push_back(candidate);
+                }
+            });
     }
-    for (auto character: alphabet)
+
+    record(tally);
+
+    if (cache != nullptr)
     {
-        std::string temp = word;
-        temp = word + character;
-        if (wordExists(temp))
-        {
-            suggestions.push_back(temp);
-        }
+        cache->insert(word, version, suggestions);
+    }
+
+    return suggestions;
+}
+
+
+std::vector<std::string> WordChecker::findSuggestionsWithin(
+    const std::string& word, unsigned int maxDistance) const
+{
+    std::vector<std::string> suggestions;
+
+    if (index != nullptr && maxDistance <= index->maxDistance())
+    {
+        suggestions = index->wordsWithin(word, maxDistance);
+        suggestions.erase(std::remove(suggestions.begin(), suggestions.end(), word), suggestions.end());
+        return suggestions;
+    }
+    else if (auto trie = dynamic_cast<const TrieSet*>(&words))
+    {
+        suggestions = trie->wordsWithin(word, maxDistance);
+        suggestions.erase(std::remove(suggestions.begin(), suggestions.end(), word), suggestions.end());
+        return suggestions;
     }
 
-    
+    // Each round makes the candidates of the words first reached in the
+    // round before, skipping any that have already been made.
+    FilterStats tally{0, 0, 0};
+    std::unordered_set<std::string> seen{word};
+    std::vector<std::string> frontier{word};
 
-    //technique 3: deleting each character from the word
-    for (int i=0;i<word.size();++i)
+    for (unsigned int distance = 1; distance <= maxDistance && !frontier.empty(); ++distance)
     {
-        std::string s3 = word;
-        s3 = s3.erase(i,1);
-        if (wordExists(s3))
+        std::vector<std::string> next;
+
+        for (const std::string& from: frontier)
         {
-            suggestions.push_back(s3);
+            forEachCandidate(from,
+                [&](const std::string& candidate, const Edit&)
+                {
+                    if (seen.insert(candidate).second)
+                    {
+                        if (lookup(
+                                [&]() { return filter->mightContain(candidate); },
+                                [&]() { return words.contains(candidate); },
+                                tally))
+                        {
+                            suggestions.push_back(candidate);
+                        }
+                        next.push_back(candidate);
+                    }
+                });
         }
 
+        frontier = std::move(next);
     }
 
-    //technique 4: replace every character with each letter
-    for (int i=0;i<word.size();++i)
+    record(tally);
+    std::sort(suggestions.begin(), suggestions.end());
+    return suggestions;
+}
+
+
+std::vector<WordChecker::WordCheckResult> WordChecker::checkWords(
+    const std::string* batch, std::size_t count, unsigned int threadCount) const
+{
+    std::vector<WordCheckResult> results(count);
+
+    forEachChunk(count, threadCount,
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                results[i].exists = wordExists(batch[i]);
+                if (!results[i].exists)
+                {
+                    results[i].suggestions = findSuggestions(batch[i]);
+                }
+            }
+        });
+
+    return results;
+}
+
+
+std::vector<WordChecker::WordCheckResult> WordChecker::checkWords(
+    const std::vector<std::string>& batch, unsigned int threadCount) const
+{
+    return checkWords(batch.data(), batch.size(), threadCount);
+}
+
+
+void WordChecker::wordsExist(
+    const std::string* batch, std::size_t count, bool* exists, unsigned int threadCount) const
+{
+    forEachChunk(count, threadCount,
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                exists[i] = wordExists(batch[i]);
+            }
+        });
+}
+
+
+std::vector<std::string> WordChecker::autocomplete(
+    const std::string& prefix, unsigned int maxResults) const
+{
+    std::vector<std::string> completions;
+
+    if (maxResults == 0)
+    {
+        return completions;
+    }
+
+    auto collect = [&](std::string_view word)
+    {
+        completions.emplace_back(word);
+        return completions.size() < maxResults;
+    };
+
+    if (auto scanner = dynamic_cast<const PrefixScanner*>(&words))
     {
-        for (auto character: alphabet)
+        scanner->scanPrefix(prefix, collect);
+    }
+
+    return completions;
+}
+
+
+void WordChecker::setFilter(const BloomFilter* filter) noexcept
+{
+    this->filter = filter;
+}
+
+
+void WordChecker::setSuggestionIndex(const SuggestionIndex* index) noexcept
+{
+    this->index = index;
+}
+
+
+void WordChecker::setSuggestionCache(SuggestionCache* cache) noexcept
+{
+    this->cache = cache;
+}
+
+
+WordChecker::FilterStats WordChecker::filterStats() const noexcept
+{
+    return FilterStats{
+        counters.lookups.load(std::memory_order_relaxed),
+        counters.rejected.load(std::memory_order_relaxed),
+        counters.falsePositives.load(std::memory_order_relaxed)};
+}
+
+
+void WordChecker::resetFilterStats() noexcept
+{
+    counters.lookups.store(0, std::memory_order_relaxed);
+    counters.rejected.store(0, std::memory_order_relaxed);
+    counters.falsePositives.store(0, std::memory_order_relaxed);
+}
+
+
+WordChecker::FilterCounters::FilterCounters() noexcept
+    : lookups{0}, rejected{0}, falsePositives{0}
+{
+}
+
+
+WordChecker::FilterCounters::FilterCounters(const FilterCounters& c) noexcept
+    : lookups{c.lookups.load(std::memory_order_relaxed)},
+      rejected{c.rejected.load(std::memory_order_relaxed)},
+      falsePositives{c.falsePositives.load(std::memory_order_relaxed)}
+{
+}
+
+
+template <typename Check>
+void WordChecker::forEachChunk(std::size_t count, unsigned int threadCount, Check&& check) const
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    std::size_t chunkCount = (count + BATCH_CHUNK_SIZE - 1) / BATCH_CHUNK_SIZE;
+    threadCount = static_cast<unsigned int>(
+        std::min<std::size_t>(threadCount, std::max<std::size_t>(chunkCount, 1)));
+
+    // Each thread repeatedly claims the next chunk of words and writes its
+    // results into their own positions, so no two threads ever touch the
+    // same result and the order comes out right without any sorting.
+    std::atomic<std::size_t> nextChunk{0};
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+
+    auto work = [&]()
+    {
+        try
         {
-            std::string s4 = word;
-            s4.at(i) = character;
-            if (wordExists(s4))
+            for (std::size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
             {
-                suggestions.push_back(s4);
+                check(chunk * BATCH_CHUNK_SIZE, std::min(count, (chunk + 1) * BATCH_CHUNK_SIZE));
             }
         }
-    }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock{failureMutex};
+            if (!failure)
+            {
+                failure = std::current_exception();
+            }
+            nextChunk = chunkCount;
+        }
+    };
 
-    //techinique 5: adding a space in between each adjacent pair of characters in the word.
-    for (int i=0;i<word.size();++i)
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+
+    // If the system won't give us as many threads as were asked for, the
+    // ones we did get (and the calling thread) simply do more chunks each.
+    for (unsigned int i = 1; i < threadCount; ++i)
     {
-        std::string s5 = word;
-        s5 = s5.insert(i, " ");
-        if (wordExists(s5))
+        try
+        {
+            threads.emplace_back(work);
+        }
+        catch (const std::system_error&)
         {
-            suggestions.push_back(s5);
+            break;
         }
-    } 
+    }
 
-    return suggestions;
+    work();
+
+    for (std::thread& thread: threads)
+    {
+        thread.join();
+    }
+
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
 }
 
+
+template <typename MightContain, typename Contains>
+bool WordChecker::lookup(MightContain&& mightContain, Contains&& contains, FilterStats& tally) const
+{
+    if (filter == nullptr)
+    {
+        return contains();
+    }
+
+    tally.lookups += 1;
+
+    if (!mightContain())
+    {
+        tally.rejected += 1;
+        return false;
+    }
+
+    bool exists = contains();
+    if (!exists)
+    {
+        tally.falsePositives += 1;
+    }
+    return exists;
+}
+
+
+void WordChecker::record(const FilterStats& tally) const noexcept
+{
+    if (tally.lookups > 0)
+    {
+        counters.lookups.fetch_add(tally.lookups, std::memory_order_relaxed);
+        counters.rejected.fetch_add(tally.rejected, std::memory_order_relaxed);
+        counters.falsePositives.fetch_add(tally.falsePositives, std::memory_order_relaxed);
+    }
+}
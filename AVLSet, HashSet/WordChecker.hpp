@@ -16,14 +16,44 @@
 #ifndef WORDCHECKER_HPP
 #define WORDCHECKER_HPP
 
+#include <atomic>
+#include <cstddef>
 #include <string>
 #include <vector>
+#include "BloomFilter.hpp"
 #include "Set.hpp"
+#include "SuggestionCache.hpp"
+#include "SuggestionIndex.hpp"
 
 
 
 class WordChecker
 {
+public:
+    // A WordCheckResult is the outcome of checking one word in a batch: whether
+    // it exists and, if it doesn't, the suggestions that findSuggestions()
+    // would return for it.
+    struct WordCheckResult
+    {
+        bool exists;
+        std::vector<std::string> suggestions;
+    };
+
+    // FilterStats counts what happened to the lookups made while a
+    // BloomFilter was attached: how many there were, how many the filter
+    // rejected without consulting the Set, and how many it let through
+    // that the Set then didn't contain.
+    struct FilterStats
+    {
+        unsigned long long lookups;
+        unsigned long long rejected;
+        unsigned long long falsePositives;
+    };
+
+    // The number of words that a thread takes at a time when checkWords()
+    // divides a batch between threads.
+    static constexpr std::size_t BATCH_CHUNK_SIZE = 64;
+
 public:
     // The constructor requires a Set of words to be passed into it.  The
     // WordChecker will store a reference to a const Set, which it will use
@@ -38,12 +68,128 @@ public:
 
     // findSuggestions() returns a vector containing suggested alternative
     // spellings for the given word, using the five algorithms described in
-    // the project write-up.
+    // the project write-up.  If a SuggestionCache is attached, the
+    // suggestions are looked for there first, and stored there once found.
+    // If the Set is a PolynomialHashLookup (see HashPolicy.hpp), each
+    // candidate is looked up by a hash found from the word's hash in
+    // constant time, rather than by hashing the candidate.  So is the
+    // BloomFilter, if one is attached and it hashes words as a
+    // PolynomialHasher does (see BloomFilter.hpp).
     std::vector<std::string> findSuggestions(const std::string& word) const;
 
 
+    // findSuggestionsWithin() returns every word in the Set that is within
+    // maxDistance edits of the given word, other than the word itself, in
+    // ascending order and without duplicates.  The edits are the ones
+    // findSuggestions() makes: inserting, deleting or replacing a
+    // character, or swapping two adjacent ones.  If a SuggestionIndex
+    // built for at least maxDistance edits is attached, this only looks
+    // the word up in the index.  Otherwise, with a TrieSet, this is one
+    // traversal of the trie (see TrieSet::wordsWithin()), which can
+    // insert or replace any character.  With any other Set, the candidates
+    // that findSuggestions() would try are made from the word, then from
+    // each of those, and so on maxDistance times, and each is looked up;
+    // their number grows very quickly with maxDistance, and a candidate
+    // reached by editing the same character twice may be included.
+    std::vector<std::string> findSuggestionsWithin(const std::string& word, unsigned int maxDistance) const;
+
+
+    // checkWords() checks the count words starting at batch, returning one
+    // result per word in the same order as the words.  The work is divided
+    // between threadCount threads (including the calling one), or one per
+    // hardware thread if threadCount is 0.  This is safe because checking
+    // a word only reads the Set, so the Set must not be modified while the
+    // batch is being checked.
+    std::vector<WordCheckResult> checkWords(
+        const std::string* batch, std::size_t count, unsigned int threadCount = 0) const;
+
+    std::vector<WordCheckResult> checkWords(
+        const std::vector<std::string>& batch, unsigned int threadCount = 0) const;
+
+
+    // wordsExist() is like checkWords(), but only sets exists[i] to
+    // whether batch[i] is spelled correctly, without finding suggestions
+    // for the words that aren't.
+    void wordsExist(
+        const std::string* batch, std::size_t count, bool* exists, unsigned int threadCount = 0) const;
+
+
+    // autocomplete() returns up to maxResults words that begin with the
+    // given prefix, in ascending order.  This needs a Set that is also a
+    // PrefixScanner (see PrefixScanner.hpp), such as an AVLSet, a
+    // BPlusTreeSet, a MappedWordSet or a TrieSet of words in their usual
+    // order; for any other kind of Set, it returns an empty vector.
+    std::vector<std::string> autocomplete(
+        const std::string& prefix, unsigned int maxResults = 10) const;
+
+
+    // setFilter() attaches a BloomFilter that wordExists() (and so
+    // findSuggestions() and checkWords()) consults before the Set, or
+    // detaches it if filter is nullptr.  Like the Set, the filter is held
+    // by reference, and it must contain every word in the Set; it may
+    // contain others, which only costs a lookup in the Set.
+    void setFilter(const BloomFilter* filter) noexcept;
+
+
+    // setSuggestionIndex() attaches a SuggestionIndex that
+    // findSuggestionsWithin() uses in place of the Set, or detaches it if
+    // index is nullptr.  The index is held by reference, and must have
+    // been built from the same words as the Set.
+    void setSuggestionIndex(const SuggestionIndex* index) noexcept;
+
+
+    // setSuggestionCache() attaches a SuggestionCache that
+    // findSuggestions() (and so checkWords()) consults before trying any
+    // candidates, or detaches it if cache is nullptr.  The cache is held
+    // by reference, and can be shared by several WordCheckers only if they
+    // have the same Set.  Suggestions are stored with the Set's
+    // modificationCount() as their version, if it's ModificationCounted
+    // (see ModificationCounted.hpp), so they're found again only until the
+    // Set is next changed.  Any other Set, such as a FrozenSet, can't be
+    // changed, and its size is used instead.
+    void setSuggestionCache(SuggestionCache* cache) noexcept;
+
+
+    // filterStats() returns the counts of lookups made through the filter
+    // since it was attached or the counts were last reset, and
+    // resetFilterStats() sets them back to zero.
+    FilterStats filterStats() const noexcept;
+    void resetFilterStats() noexcept;
+
+
 private:
+    // The counts are kept in a tally by each call and added to the shared
+    // atomic counters once at the end, so that the threads of checkWords()
+    // don't all write to the same counters for every candidate.
+    struct FilterCounters
+    {
+        FilterCounters() noexcept;
+        FilterCounters(const FilterCounters& c) noexcept;
+
+        std::atomic<unsigned long long> lookups;
+        std::atomic<unsigned long long> rejected;
+        std::atomic<unsigned long long> falsePositives;
+    };
+
     const Set<std::string>& words;
+    const BloomFilter* filter;
+    const SuggestionIndex* index;
+    SuggestionCache* cache;
+    mutable FilterCounters counters;
+
+    // forEachChunk() calls check(begin, end) for each chunk of
+    // BATCH_CHUNK_SIZE positions from 0 to count - 1, dividing the chunks
+    // between threadCount threads as checkWords() describes, and rethrows
+    // the first exception that any of the calls throws.
+    template <typename Check>
+    void forEachChunk(std::size_t count, unsigned int threadCount, Check&& check) const;
+
+    // lookup() consults the filter, if there is one, by calling
+    // mightContain(), and then calls contains() to look the word up in the
+    // Set, counting the outcome in the tally.
+    template <typename MightContain, typename Contains>
+    bool lookup(MightContain&& mightContain, Contains&& contains, FilterStats& tally) const;
+    void record(const FilterStats& tally) const noexcept;
 };
 
 